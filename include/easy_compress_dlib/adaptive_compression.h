@@ -0,0 +1,50 @@
+#ifndef EASY_COMPRESS_DLIB_ADAPTIVE_COMPRESSION_H
+#define EASY_COMPRESS_DLIB_ADAPTIVE_COMPRESSION_H
+
+#include "block_stream.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace easy_compress_dlib {
+
+struct AdaptiveOptions {
+    std::size_t block_size = default_block_size;
+    unsigned threads = 0;   // 0 = hardware concurrency
+    // Prefill the history of LZ77 blocks with the tail of the previous block's
+    // raw data, so matches are not lost at block boundaries. Only compress_blocks
+    // with lz77_kernel_index accepts it; compress_adaptive never selects LZ77
+    // and throws std::invalid_argument. Blocks still compress concurrently, but
+    // a primed block decodes after its predecessor, so a stream primed
+    // throughout decodes serially even with several threads.
+    bool cross_block_window = false;
+    // Run preprocessing filters (delta, record transposition, x86 BCJ) chosen
+    // per block from its content; the chain is recorded in the block
+    bool filters = false;
+    // Bytes all block tasks together may use, 0 for no limit: shrinks the
+    // LZ77 window and holds tasks back until their memory is free (see
+    // memory_budget.h)
+    std::size_t memory_limit = 0;
+};
+
+// Classify every block on its own and compress it with the best kernel for its
+// detected type. Each block header records its kernel, so blocks stay
+// independently decodable (see decode_block_stream). Blocks that are a single
+// run of one byte become run blocks without running a kernel. Returns the
+// kernel chosen per block, 0 for run blocks. Throws std::invalid_argument if
+// options.cross_block_window is set.
+std::vector<int> compress_adaptive(const std::string& input, std::string& output, double alpha,
+                                   const AdaptiveOptions& options = {});
+
+// Compress every block with the same kernel (a codec index, see kernel_table.h).
+// Throws std::invalid_argument if options.cross_block_window is set for
+// another kernel than lz77_kernel_index.
+void compress_blocks(const std::string& input, std::string& output, int kernel_index,
+                     const AdaptiveOptions& options = {});
+
+std::vector<int> easy_compress_adaptive(const std::string& input_filepath, const std::string& output_filepath,
+                                        double alpha, const AdaptiveOptions& options = {});
+
+} // namespace easy_compress_dlib
+
+#endif // EASY_COMPRESS_DLIB_ADAPTIVE_COMPRESSION_H
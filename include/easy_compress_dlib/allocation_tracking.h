@@ -0,0 +1,46 @@
+#ifndef EASY_COMPRESS_DLIB_ALLOCATION_TRACKING_H
+#define EASY_COMPRESS_DLIB_ALLOCATION_TRACKING_H
+
+#include <cstdint>
+
+namespace easy_compress_dlib {
+
+// Allocation audit mode
+//
+// Building src/allocation_tracking.cpp with EASY_COMPRESS_DLIB_TRACK_ALLOCATIONS
+// defined replaces the global operator new and delete with versions that
+// count, per thread, every allocation and the bytes requested. Replacing them
+// affects the whole program, so it is meant for test and audit builds. The
+// counters cover all code on the thread, the library's and the caller's.
+//
+// Kernel calls record their own allocations into the metrics (metrics.h).
+// Without the replacement every count stays 0.
+
+struct AllocationStats {
+    std::uint64_t allocations = 0;
+    std::uint64_t deallocations = 0;
+    std::uint64_t bytes = 0;   // requested by allocations, never reduced by frees
+};
+
+AllocationStats operator-(const AllocationStats& end, const AllocationStats& start);
+
+// Whether operator new is being counted
+bool allocation_tracking_available();
+
+// Totals for the calling thread since it started
+AllocationStats thread_allocation_stats();
+
+// Allocations made by the calling thread while the scope lives
+class AllocationScope {
+public:
+    AllocationScope() : start_(thread_allocation_stats()) {}
+
+    AllocationStats stats() const { return thread_allocation_stats() - start_; }
+
+private:
+    AllocationStats start_;
+};
+
+} // namespace easy_compress_dlib
+
+#endif // EASY_COMPRESS_DLIB_ALLOCATION_TRACKING_H
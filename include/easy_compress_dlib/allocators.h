@@ -0,0 +1,126 @@
+#ifndef EASY_COMPRESS_DLIB_ALLOCATORS_H
+#define EASY_COMPRESS_DLIB_ALLOCATORS_H
+
+#include <cstddef>
+#include <new>
+
+namespace easy_compress_dlib {
+
+// Allocators for Vector (custom_vector.h), sliding_buffer and the lz77_buffer
+// kernels, all of which take a standard allocator argument.
+
+// Monotonic arena
+//
+// Allocation bumps a pointer through a chain of blocks and deallocation does
+// nothing. release() rewinds to the first block in O(1), keeping every block
+// for reuse, so an arena that has seen its largest workload allocates nothing
+// more. Requests larger than the block size get a block of their own.
+// Not thread safe.
+class MonotonicArena {
+public:
+    explicit MonotonicArena(std::size_t block_size = 64 * 1024);
+    ~MonotonicArena();
+
+    MonotonicArena(const MonotonicArena&) = delete;
+    MonotonicArena& operator=(const MonotonicArena&) = delete;
+
+    // alignment must be a power of two
+    void* allocate(std::size_t bytes, std::size_t alignment = alignof(std::max_align_t));
+    void release();
+
+    std::size_t bytes_in_use() const { return in_use_; }
+    std::size_t bytes_reserved() const { return reserved_; }
+
+private:
+    struct Block {
+        Block* next;
+        std::size_t size;   // usable bytes after the header
+    };
+
+    static char* block_data(Block* block) { return reinterpret_cast<char*>(block + 1); }
+    void* allocate_slow(std::size_t bytes, std::size_t alignment);
+
+    std::size_t block_size_;
+    Block* first_ = nullptr;
+    Block* current_ = nullptr;
+    char* cursor_ = nullptr;
+    char* end_ = nullptr;
+    std::size_t in_use_ = 0;       // bytes handed out since the last release, with padding
+    std::size_t reserved_ = 0;     // bytes in all blocks
+};
+
+// Standard allocator over a MonotonicArena; deallocate is a no-op and the
+// memory comes back when the arena is released
+template <typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    explicit ArenaAllocator(MonotonicArena& arena) noexcept : arena_(&arena) {}
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) noexcept : arena_(other.arena()) {}
+
+    T* allocate(std::size_t n) {
+        if (n > static_cast<std::size_t>(-1) / sizeof(T)) {
+            throw std::bad_array_new_length();
+        }
+        return static_cast<T*>(arena_->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T*, std::size_t) noexcept {}
+
+    MonotonicArena* arena() const noexcept { return arena_; }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const noexcept { return arena_ == other.arena(); }
+
+private:
+    MonotonicArena* arena_;
+};
+
+// Thread-local size-class pool
+//
+// Requests are rounded up to a power of two from pool_min_size to
+// pool_max_size and served from a per-thread free list of that class, falling
+// back to operator new; larger requests go straight to operator new. Freed
+// blocks go to the free list of the thread that frees them, up to
+// pool_cache_bytes per class, and a thread's lists are returned to operator
+// delete when it exits. No locks are taken.
+constexpr std::size_t pool_min_size = 16;
+constexpr std::size_t pool_max_size = std::size_t(4) << 20;
+constexpr std::size_t pool_cache_bytes = std::size_t(8) << 20;
+
+// Blocks are aligned like operator new's, to alignof(std::max_align_t)
+void* pool_allocate(std::size_t bytes);
+// bytes must be the size passed to pool_allocate
+void pool_deallocate(void* p, std::size_t bytes) noexcept;
+
+template <typename T>
+class PoolAllocator {
+    static_assert(alignof(T) <= alignof(std::max_align_t), "PoolAllocator cannot over-align");
+
+public:
+    using value_type = T;
+
+    PoolAllocator() noexcept = default;
+
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U>&) noexcept {}
+
+    T* allocate(std::size_t n) {
+        if (n > static_cast<std::size_t>(-1) / sizeof(T)) {
+            throw std::bad_array_new_length();
+        }
+        return static_cast<T*>(pool_allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept { pool_deallocate(p, n * sizeof(T)); }
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U>&) const noexcept { return true; }
+};
+
+} // namespace easy_compress_dlib
+
+#endif // EASY_COMPRESS_DLIB_ALLOCATORS_H
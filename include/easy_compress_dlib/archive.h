@@ -0,0 +1,77 @@
+#ifndef EASY_COMPRESS_DLIB_ARCHIVE_H
+#define EASY_COMPRESS_DLIB_ARCHIVE_H
+
+#include "block_stream.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace easy_compress_dlib {
+
+// Multi-file archives
+//
+// A directory tree is stored as one sequence of blocks. The raw data of all
+// blocks, concatenated, holds the contents of every file back to back. Small
+// files are grouped by detected type into solid blocks and share one kernel
+// selection; larger files are split into blocks of their own, each classified
+// on its own. Reading the index at the end of the archive is enough to
+// extract a single file without decoding unrelated blocks.
+//
+//   "ECAR" | u8 version
+//   per block:  the block header and payload of a block stream (see
+//               block_stream.h); never primed
+//   index:      u32 block_count | per block: u64 block_offset | u32 raw_size
+//               u32 entry_count | per entry: u16 path_size | path |
+//                                            u64 raw_offset | u64 size
+//   u64 index_offset
+//
+// Paths are relative to the archived directory with '/' separators, and
+// entries are sorted by path. Only regular files are stored; symbolic links
+// and empty directories are skipped. All integers are little endian.
+
+constexpr char archive_magic[4] = {'E', 'C', 'A', 'R'};
+constexpr std::uint8_t archive_version = 1;
+
+struct ArchiveOptions {
+    std::size_t block_size = default_block_size;
+    // Files up to this size are grouped into solid blocks of about solid_block_size
+    std::size_t small_file_limit = 64 * 1024;
+    std::size_t solid_block_size = 1024 * 1024;
+    unsigned threads = 0;   // 0 = hardware concurrency
+    // Bytes all block tasks together may use, 0 for no limit (see memory_budget.h)
+    std::size_t memory_limit = 0;
+};
+
+struct ArchiveEntry {
+    std::string path;
+    std::uint64_t raw_offset = 0;   // in the concatenated raw data of the blocks
+    std::uint64_t size = 0;
+};
+
+struct ArchiveReport {
+    std::size_t files = 0;
+    std::size_t solid_blocks = 0;   // blocks holding grouped small files
+    std::size_t blocks = 0;         // all blocks, solid ones included
+    std::uint64_t raw_bytes = 0;
+};
+
+// Files are read, classified and compressed as tasks on one work-stealing
+// pool. Throws std::runtime_error if the directory cannot be read or the
+// archive cannot be written.
+ArchiveReport create_archive(const std::string& directory, const std::string& archive_filepath, double alpha,
+                             const ArchiveOptions& options = {});
+
+// Throw std::runtime_error on a malformed archive
+std::vector<ArchiveEntry> list_archive(const std::string& archive_filepath);
+// Decodes only the blocks holding the file. Throws std::out_of_range if the
+// archive has no such entry.
+std::string extract_archive_file(const std::string& archive_filepath, const std::string& path);
+// Recreates the tree under output_directory. Throws std::runtime_error for an
+// entry whose path would leave it.
+void extract_archive(const std::string& archive_filepath, const std::string& output_directory,
+                     unsigned threads = 0);
+
+} // namespace easy_compress_dlib
+
+#endif // EASY_COMPRESS_DLIB_ARCHIVE_H
@@ -0,0 +1,112 @@
+#ifndef EASY_COMPRESS_DLIB_BENCHMARK_H
+#define EASY_COMPRESS_DLIB_BENCHMARK_H
+
+#include "hw_profiler.h"
+#include "kernel_table.h"
+#include "lz77_codec.h"
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace easy_compress_dlib {
+
+// Benchmark runner
+//
+// Every subject is a compress/decompress pair run over the synthetic corpus
+// (synthetic_corpus.h) for each file type and input size. A case is one
+// subject on one input: an untimed warm-up call checks the round trip and
+// gives the compressed size, then each repetition times one compress and one
+// decompress call. Latency percentiles are taken over the repetitions.
+
+struct BenchmarkSubject {
+    std::string name;
+    kernel_function compress;
+    decompress_function decompress;   // given the input size as max_size
+    // Larger inputs are skipped, for subjects too slow to finish on them
+    std::size_t max_input_size = std::numeric_limits<std::size_t>::max();
+};
+
+// Every codec of kernel_table.h, named as there
+std::vector<BenchmarkSubject> kernel_subjects();
+
+// The LZ77 token codec over each lz77_buffer kernel instantiation:
+// lz77_buffer_kernel_{1,2} and lz77_buffer_kernel_c over both. kernel_1
+// searches the whole window for every symbol, so it is limited to small inputs.
+std::vector<BenchmarkSubject> lz77_buffer_subjects();
+
+// The LZ77 token format (lz77_codec.h) produced through any lz77_buffer
+// kernel, without the run detector, so match finders can be compared on equal
+// terms. Decodes with the lz77_kernel_index decompressor.
+template <typename Kernel>
+void compress_lz77_with_buffer(const std::string& input, std::string& output) {
+    ProfileScope scope(profile_region(ProfileRegion::lz77_parse), input.size());
+    Kernel kernel(lz77_total_limit, lz77_lookahead_limit);
+    output.clear();
+    lz77_encode_segment(kernel, input, output);
+}
+
+struct BenchmarkOptions {
+    std::vector<std::string> file_types;   // empty: all known file types
+    std::vector<std::size_t> sizes = {1024, 64 * 1024, 1024 * 1024};
+    unsigned repetitions = 5;
+    // Repetitions are cut so that no case processes more than this many bytes,
+    // with at least one repetition
+    std::uint64_t max_bytes_per_case = std::uint64_t(1) << 30;
+    std::uint64_t seed = 0;
+    // Read hardware counters around every timed call (hw_profiler.h)
+    bool hardware_counters = false;
+};
+
+struct BenchmarkResult {
+    std::string subject;
+    std::string file_type;
+    std::size_t input_size = 0;
+    std::size_t compressed_size = 0;
+    bool round_trip = false;
+    std::string error;                        // what() of an exception thrown by the subject
+    std::vector<double> compress_seconds;     // one per repetition
+    std::vector<double> decompress_seconds;
+    std::uint64_t peak_rss_bytes = 0;         // 0 if unknown
+    // Summed over the repetitions, with hardware_counters
+    CounterReading compress_counters;
+    CounterReading decompress_counters;
+
+    double bits_per_byte() const;
+    // From the median repetition
+    double compress_mb_per_second() const;
+    double decompress_mb_per_second() const;
+};
+
+// Nearest-rank percentile (p in [0, 100]) of samples; 0 for none
+double percentile(std::vector<double> samples, double p);
+
+// Timed repetitions run_benchmark_case makes for an input of this size
+unsigned benchmark_repetitions(std::size_t input_size, const BenchmarkOptions& options);
+
+BenchmarkResult run_benchmark_case(const BenchmarkSubject& subject, std::string_view file_type,
+                                   const std::string& input, const BenchmarkOptions& options);
+
+// All subjects over all file types and sizes; the corpus for each file type
+// and size is generated once. progress, if given, is called before each case.
+std::vector<BenchmarkResult> run_benchmarks(const std::vector<BenchmarkSubject>& subjects,
+                                            const BenchmarkOptions& options,
+                                            void (*progress)(const BenchmarkSubject&, std::string_view file_type,
+                                                             std::size_t size) = nullptr);
+
+// {"schema": "easy_compress_dlib.benchmark.v1", "seed", "repetitions", "results": [...]}
+// with raw per-repetition timings in every result, and with hardware_counters
+// the counts per input byte for compress and decompress
+std::string benchmark_results_json(const std::vector<BenchmarkResult>& results, const BenchmarkOptions& options);
+
+// Peak resident set size of the process in bytes, 0 if unknown. On Linux the
+// peak can be reset so that it covers a single case; reset_peak_rss returns
+// false where it cannot.
+std::uint64_t peak_rss_bytes();
+bool reset_peak_rss();
+
+} // namespace easy_compress_dlib
+
+#endif // EASY_COMPRESS_DLIB_BENCHMARK_H
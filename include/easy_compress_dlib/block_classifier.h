@@ -0,0 +1,33 @@
+#ifndef EASY_COMPRESS_DLIB_BLOCK_CLASSIFIER_H
+#define EASY_COMPRESS_DLIB_BLOCK_CLASSIFIER_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace easy_compress_dlib {
+
+// Byte statistics gathered from a sample of a block
+struct BlockFeatures {
+    std::size_t sampled = 0;
+    double zero_fraction = 0.0;
+    double binary_fraction = 0.0;      // control bytes other than whitespace, and bytes >= 0x80
+    double markup_fraction = 0.0;      // '<' and '>'
+    double c_syntax_fraction = 0.0;    // '{', '}', ';', '#'
+    double paren_fraction = 0.0;       // '(' and ')'
+    double upper_fraction = 0.0;
+    double troff_line_fraction = 0.0;  // lines starting with '.'
+    double average_line_length = 0.0;
+    double call_opcode_fraction = 0.0; // x86 0xE8 / 0xE9
+};
+
+// Examine at most sample_limit bytes spread evenly over the block
+BlockFeatures compute_block_features(std::string_view block, std::size_t sample_limit = 4096);
+
+// Cheaply map a block onto one of the file types in the kernel metrics
+// ("text", "play", "html", "Csrc", "list", "Excl", "tech", "poem", "fax", "SPRC", "man")
+std::string classify_block(std::string_view block);
+
+} // namespace easy_compress_dlib
+
+#endif // EASY_COMPRESS_DLIB_BLOCK_CLASSIFIER_H
@@ -0,0 +1,111 @@
+#ifndef EASY_COMPRESS_DLIB_BLOCK_STREAM_H
+#define EASY_COMPRESS_DLIB_BLOCK_STREAM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace easy_compress_dlib {
+
+// Block stream container
+//
+// A block stream is a sequence of independently decodable blocks, each tagged
+// with the kernel that compressed it:
+//
+//   "ECBS" | u8 version
+//   per block:  u8 kernel_index | u8 flags | u32 raw_size | u32 payload_size | payload
+//   end marker: u8 0
+//
+// All integers are little endian.
+//
+// Blocks with block_flag_primed set were compressed with the tail of the
+// previous block's raw data as history, and can only be decoded after it.
+//
+// Blocks with block_flag_run set are one byte repeated raw_size times (a skip
+// block when it is zero). The payload is that byte; the kernel index is
+// lz77_kernel_index but no kernel runs.
+//
+// Blocks with block_flag_filtered set were passed through preprocessing
+// filters before their kernel; the payload starts with the filter chain (see
+// filters.h) and the inverse filters run after the kernel.
+
+constexpr char block_stream_magic[4] = {'E', 'C', 'B', 'S'};
+constexpr std::uint8_t block_stream_version = 1;
+constexpr std::size_t block_header_size = 10;
+constexpr std::size_t default_block_size = 256 * 1024;
+// raw_size and payload_size are u32
+constexpr std::size_t max_block_size = UINT32_MAX;
+
+// Block flags
+constexpr std::uint8_t block_flag_primed = 0x01;
+constexpr std::uint8_t block_flag_run = 0x02;
+constexpr std::uint8_t block_flag_filtered = 0x04;
+
+struct BlockView {
+    int kernel_index;
+    std::uint8_t flags;
+    std::uint32_t raw_size;
+    std::string_view payload;
+};
+
+// Little endian helpers shared by the container formats
+inline void put_u32(std::string& out, std::uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+inline void put_u64(std::string& out, std::uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+inline std::uint32_t get_u32(const char* p) {
+    std::uint32_t value = 0;
+    for (int i = 0; i < 4; ++i) {
+        value |= static_cast<std::uint32_t>(static_cast<unsigned char>(p[i])) << (8 * i);
+    }
+    return value;
+}
+
+inline std::uint64_t get_u64(const char* p) {
+    std::uint64_t value = 0;
+    for (int i = 0; i < 8; ++i) {
+        value |= static_cast<std::uint64_t>(static_cast<unsigned char>(p[i])) << (8 * i);
+    }
+    return value;
+}
+
+// Writing. The append functions throw std::invalid_argument for a raw or
+// payload size above max_block_size.
+void begin_block_stream(std::string& out);
+void append_block(std::string& out, int kernel_index, std::string_view raw);
+void append_compressed_block(std::string& out, int kernel_index, std::uint8_t flags,
+                             std::size_t raw_size, std::string_view payload);
+void append_run_block(std::string& out, unsigned char value, std::size_t raw_size);
+void end_block_stream(std::string& out);
+
+// Reading. parse_block_stream throws std::runtime_error on a malformed stream.
+std::vector<BlockView> parse_block_stream(std::string_view stream);
+void decode_block(const BlockView& block, std::string& output);
+// history is the previous block's raw data, used if the block is primed. It may
+// view into output.
+void decode_block(const BlockView& block, std::string_view history, std::string& output);
+void decode_block_stream(std::string_view stream, std::string& output);
+// Runs of primed blocks are decoded in order, the runs themselves concurrently
+// (threads = 0: hardware concurrency). A stream whose blocks are all primed is
+// a single run and decodes on one thread.
+void decode_block_stream(std::string_view stream, std::string& output, unsigned threads);
+
+// Whole-file helpers
+std::string read_file(const std::string& filepath);
+void write_file(const std::string& filepath, std::string_view contents);
+void easy_decompress_blocks(const std::string& input_filepath, const std::string& output_filepath,
+                            unsigned threads = 1);
+
+} // namespace easy_compress_dlib
+
+#endif // EASY_COMPRESS_DLIB_BLOCK_STREAM_H
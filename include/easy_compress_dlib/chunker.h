@@ -0,0 +1,51 @@
+#ifndef EASY_COMPRESS_DLIB_CHUNKER_H
+#define EASY_COMPRESS_DLIB_CHUNKER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace easy_compress_dlib {
+
+// Content-defined chunking (FastCDC)
+//
+// Cut points depend only on the bytes around them, so an insertion early in a
+// file only changes the chunks next to it and the rest still deduplicate. The
+// gear hash from rolling_hash.h is tested with a stricter mask before
+// avg_size and a looser one after it (normalized chunking), which keeps chunk
+// sizes close to avg_size. The first min_size - 64 bytes of a chunk are
+// skipped without hashing.
+
+struct ChunkerOptions {
+    std::size_t min_size = 2 * 1024;
+    std::size_t avg_size = 8 * 1024;    // rounded down to a power of two
+    std::size_t max_size = 64 * 1024;
+};
+
+// Length of the chunk at the start of data. Throws std::invalid_argument unless
+// 64 <= min_size < avg_size < max_size.
+std::size_t next_chunk_size(std::string_view data, const ChunkerOptions& options = {});
+
+std::vector<std::string_view> split_chunks(std::string_view data, const ChunkerOptions& options = {});
+
+// 128-bit content fingerprint. It is not cryptographic: chunks from untrusted
+// sources could be made to collide.
+struct ChunkFingerprint {
+    std::uint64_t low = 0;
+    std::uint64_t high = 0;
+
+    bool operator==(const ChunkFingerprint&) const = default;
+};
+
+ChunkFingerprint fingerprint_chunk(std::string_view data);
+
+struct ChunkFingerprintHash {
+    std::size_t operator()(const ChunkFingerprint& fingerprint) const {
+        return static_cast<std::size_t>(fingerprint.low);
+    }
+};
+
+} // namespace easy_compress_dlib
+
+#endif // EASY_COMPRESS_DLIB_CHUNKER_H
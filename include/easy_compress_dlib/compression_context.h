@@ -0,0 +1,55 @@
+#ifndef EASY_COMPRESS_DLIB_COMPRESSION_CONTEXT_H
+#define EASY_COMPRESS_DLIB_COMPRESSION_CONTEXT_H
+
+#include "lz77_codec.h"
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace easy_compress_dlib {
+
+// Reusable state for repeated compress and decompress calls
+//
+// compress_lz77 builds a kernel, with its node and hash tables, on every call.
+// A context builds one and clears it between calls, and keeps the scratch
+// buffers the other paths need. Once a context has handled the largest input
+// of each kind, LZ77 and run blocks make no heap allocation, provided the
+// caller also reuses its output strings, which keep their capacity. The other
+// codecs are dlib compress_stream kernels that allocate internally; for them
+// the context only saves copying the input.
+//
+// A context is not thread safe: use one per thread.
+
+class CompressionContext {
+public:
+    CompressionContext();
+
+    CompressionContext(const CompressionContext&) = delete;
+    CompressionContext& operator=(const CompressionContext&) = delete;
+
+    // Same output as compress_with_kernel / decompress_with_kernel, with the
+    // same max_size bound
+    void compress(int codec_index, std::string_view input, std::string& output);
+    void decompress(int codec_index, std::string_view input, std::string& output, std::size_t max_size);
+
+    // Same output as compress_lz77_primed / decompress_lz77_primed
+    void compress_lz77_primed(std::string_view history, std::string_view input, std::string& output);
+    void decompress_lz77_primed(std::string_view history, std::string_view input, std::string& output,
+                                std::size_t max_size);
+
+    // Scratch for callers that need a payload buffer per block
+    std::string& payload() { return payload_; }
+
+private:
+    lz77_kernel kernel_;
+    std::string input_;     // for kernel_function, which takes const std::string&
+    std::string scratch_;
+    std::string payload_;
+};
+
+// append_block (block_stream.h) through a context
+void append_block(std::string& out, int kernel_index, std::string_view raw, CompressionContext& context);
+
+} // namespace easy_compress_dlib
+
+#endif // EASY_COMPRESS_DLIB_COMPRESSION_CONTEXT_H
@@ -2,15 +2,25 @@
 #define COMPRESSION_PROFILES_H
 
 #include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cstdint>
 #include <fstream>
 #include <functional>
 #include <iostream>
 #include <map>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <tuple>
 #include <type_traits>
 #include <utility>
+#include <vector>
 #include <concepts>
+#include "kernel_selection.h"
 
 namespace easy_compress_dlib {
 
@@ -29,40 +39,148 @@ concept valid_compression_profile = is_tuple<T>::value && std::tuple_size<T>::va
                                    std::is_floating_point_v<std::tuple_element_t<2, T>> &&
                                    std::is_integral_v<std::tuple_element_t<3, T>>;
 
-// Kernel selection function (placeholder) - get from kernel_selection
-// template <std::string file_type, double alpha>
-// int kernel_selection() {
-//     // Implement your kernel selection logic here
-//     return 123;
-// }
+// One row of a profile CSV file, viewing into the line it was parsed from
+struct ProfileCsvRow {
+    std::string_view profile_name;
+    std::string_view file_type;
+    double alpha = 0.0;
+    int kernel = 0;
+};
+
+enum class ProfileCsvStatus { ok, wrong_field_count, bad_number };
+
+// Header line written by CompressionProfiles::save_profiles
+constexpr std::string_view profile_metrics_fingerprint_prefix = "# metrics_fingerprint=";
+
+// Parse "profile_name,file_type,alpha,kernel" in place with std::from_chars
+inline ProfileCsvStatus parse_profile_csv_row(std::string_view line, ProfileCsvRow& row) {
+    if (!line.empty() && line.back() == '\r') {
+        line.remove_suffix(1);
+    }
+    std::string_view fields[4];
+    std::size_t count = 0;
+    while (true) {
+        std::size_t comma = line.find(',');
+        if (count == 4) {
+            return ProfileCsvStatus::wrong_field_count;
+        }
+        fields[count++] = line.substr(0, comma);
+        if (comma == std::string_view::npos) {
+            break;
+        }
+        line.remove_prefix(comma + 1);
+    }
+    if (count != 4) {
+        return ProfileCsvStatus::wrong_field_count;
+    }
+
+    row.profile_name = fields[0];
+    row.file_type = fields[1];
+    const char* alpha_end = fields[2].data() + fields[2].size();
+    const char* kernel_end = fields[3].data() + fields[3].size();
+    auto alpha_result = std::from_chars(fields[2].data(), alpha_end, row.alpha);
+    auto kernel_result = std::from_chars(fields[3].data(), kernel_end, row.kernel);
+    if (alpha_result.ec != std::errc() || alpha_result.ptr != alpha_end ||
+        kernel_result.ec != std::errc() || kernel_result.ptr != kernel_end) {
+        return ProfileCsvStatus::bad_number;
+    }
+    return ProfileCsvStatus::ok;
+}
 
 // Compression profile class
+//
+// The kernel is resolved lazily on the first get_kernel(), at most once even
+// when several threads ask at the same time. A kernel passed to the constructor
+// is trusted as long as it was resolved with metrics of the current fingerprint.
+// Copies and assignments take over the resolved kernel if there is one and
+// resolve their own otherwise; assigning while another thread calls
+// get_kernel() on the same profile is a data race, as for any object.
 template <typename ProfileName = std::string, typename FileType= std::string, typename Alpha = double, typename Kernel = int>
 class CompressionProfile {
 public:
     CompressionProfile(ProfileName&& profile_name, FileType&& file_type, Alpha alpha)
         : profile_name_(std::forward<ProfileName>(profile_name)),
           file_type_(std::forward<FileType>(file_type)),
-          alpha_(alpha),
-          kernel_(kernel_selection<FileType, Alpha>(file_type_, alpha_)) {}
+          alpha_(alpha) {}
+
+    CompressionProfile(ProfileName&& profile_name, FileType&& file_type, Alpha alpha, Kernel kernel,
+                       std::uint64_t metrics_fingerprint = kernel_metrics_fingerprint())
+        : CompressionProfile(std::forward<ProfileName>(profile_name), std::forward<FileType>(file_type), alpha) {
+        if (metrics_fingerprint == kernel_metrics_fingerprint()) {
+            kernel_ = kernel;
+            resolved_.store(true, std::memory_order_relaxed);
+        }
+    }
+
+    CompressionProfile(const CompressionProfile& other)
+        : profile_name_(other.profile_name_), file_type_(other.file_type_), alpha_(other.alpha_) {
+        copy_kernel_from(other);
+    }
+
+    CompressionProfile(CompressionProfile&& other) noexcept
+        : profile_name_(std::move(other.profile_name_)), file_type_(std::move(other.file_type_)), alpha_(other.alpha_) {
+        copy_kernel_from(other);
+    }
+
+    CompressionProfile& operator=(const CompressionProfile& other) {
+        if (this != &other) {
+            profile_name_ = other.profile_name_;
+            file_type_ = other.file_type_;
+            alpha_ = other.alpha_;
+            copy_kernel_from(other);
+        }
+        return *this;
+    }
+
+    CompressionProfile& operator=(CompressionProfile&& other) noexcept {
+        if (this != &other) {
+            profile_name_ = std::move(other.profile_name_);
+            file_type_ = std::move(other.file_type_);
+            alpha_ = other.alpha_;
+            copy_kernel_from(other);
+        }
+        return *this;
+    }
 
     const ProfileName& get_profile_name() const { return profile_name_; }
     const FileType& get_file_type() const { return file_type_; }
     Alpha get_alpha() const { return alpha_; }
-    Kernel get_kernel() const { return kernel_; }
+
+    Kernel get_kernel() const {
+        if (!resolved_.load(std::memory_order_acquire)) {
+            std::lock_guard<std::mutex> lock(resolve_mutex_);
+            if (!resolved_.load(std::memory_order_relaxed)) {
+                kernel_ = kernel_selection<FileType, Alpha>(file_type_, alpha_);
+                resolved_.store(true, std::memory_order_release);
+            }
+        }
+        return kernel_;
+    }
+
+    bool is_kernel_resolved() const { return resolved_.load(std::memory_order_acquire); }
 
 private:
+    // The mutex only guards resolving and is never copied; a profile that
+    // takes over no kernel resolves again for its new file type and alpha
+    void copy_kernel_from(const CompressionProfile& other) {
+        const bool resolved = other.resolved_.load(std::memory_order_acquire);
+        kernel_ = resolved ? other.kernel_ : Kernel{};
+        resolved_.store(resolved, std::memory_order_relaxed);
+    }
+
     ProfileName profile_name_;
     FileType file_type_;
     Alpha alpha_;
-    Kernel kernel_;
+    mutable Kernel kernel_{};
+    mutable std::atomic<bool> resolved_{false};
+    mutable std::mutex resolve_mutex_;
 };
 
 // Compression profiles container
 template <typename Profile>
 class CompressionProfiles {
 public:
-    // Add a new profile
+    // Add a new profile; the first profile with a name wins
     void add_profile(Profile&& profile) {
         profiles_.emplace(profile.get_profile_name(), std::forward<Profile>(profile));
     }
@@ -88,10 +206,13 @@ public:
         }
     }
 
-    // Save profiles to a file
+    // Save profiles to a file. The first line records the fingerprint of the
+    // metrics the kernels were resolved with, so load_profiles in any process
+    // can tell whether to trust the kernel column.
     void save_profiles(const std::string& filename) const {
         std::ofstream file(filename);
         if (file.is_open()) {
+            file << profile_metrics_fingerprint_prefix << kernel_metrics_fingerprint() << std::endl;
             for (const auto& [name, profile] : profiles_) {
                 file << name << "," << profile.get_file_type() << ","
                      << profile.get_alpha() << "," << profile.get_kernel() << std::endl;
@@ -110,39 +231,48 @@ public:
 
         std::string line;
         int line_number = 1; // Track line number for error reporting
+        ProfileCsvRow row;
+        std::optional<std::uint64_t> metrics_fingerprint; // absent in files written before it was recorded
         while (std::getline(input_file, line)) {
-            std::istringstream line_stream(line); // Changed to std::istringstream
-            std::string cell;
-            std::vector<std::string> values;
-
-        // Extract comma-separated values
-        while (std::getline(line_stream, cell, ',')) {
-            values.push_back(cell);
-        }
-
-            if (values.size() == 4) {
-                try {
-                    std::string profile_name = values[0];
-                    std::string file_type = values[1];
-                    double alpha = std::stod(values[2]);
-                    int kernel = std::stoi(values[3]);
-
-                    // Create a temporary profile and add it to the profiles_ map
-                    CompressionProfile profile(profile_name, file_type, alpha);
-                    profiles_.emplace(profile_name, std::move(profile));
-                } catch (const std::exception& e) {
-                    // Handle conversion errors (e.g., invalid alpha or kernel)
-                    std::cerr << "Error on line " << line_number << ": " << e.what() << std::endl;
+            if (line_number == 1 && line.rfind(profile_metrics_fingerprint_prefix, 0) == 0) {
+                std::uint64_t fingerprint = 0;
+                const char* begin = line.data() + profile_metrics_fingerprint_prefix.size();
+                if (std::from_chars(begin, line.data() + line.size(), fingerprint).ec == std::errc()) {
+                    metrics_fingerprint = fingerprint;
                 }
-            } else {
-                // Handle lines with incorrect number of values
-                std::cerr << "Incorrect format on line " << line_number << ": Expected 4 comma-separated values" << std::endl;
+                line_number++;
+                continue;
+            }
+            switch (parse_profile_csv_row(line, row)) {
+                case ProfileCsvStatus::ok: {
+                    // Create a temporary profile and add it to the profiles_ map; the stored
+                    // kernel is only used if it is valid and was resolved with the current metrics
+                    std::string profile_name(row.profile_name);
+                    if (metrics_fingerprint && is_valid_kernel_index(row.kernel)) {
+                        profiles_.emplace(profile_name, Profile(std::string(profile_name), std::string(row.file_type),
+                                                                row.alpha, row.kernel, *metrics_fingerprint));
+                    } else {
+                        profiles_.emplace(profile_name, Profile(std::string(profile_name), std::string(row.file_type),
+                                                                row.alpha));
+                    }
+                    break;
+                }
+                case ProfileCsvStatus::bad_number:
+                    // Handle conversion errors (e.g., invalid alpha or kernel)
+                    std::cerr << "Error on line " << line_number << ": invalid alpha or kernel" << std::endl;
+                    break;
+                case ProfileCsvStatus::wrong_field_count:
+                    // Handle lines with incorrect number of values
+                    std::cerr << "Incorrect format on line " << line_number << ": Expected 4 comma-separated values" << std::endl;
+                    break;
             }
 
             line_number++;
         }
     }
 
+    const std::map<std::string, Profile>& get_profiles() const { return profiles_; }
+
 private:
     std::map<std::string, Profile> profiles_;
 };
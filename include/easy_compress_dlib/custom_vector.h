@@ -6,6 +6,8 @@
 #include <bits/stdc++.h>
 #include <type_traits>
 #include <algorithm>
+#include <cstring>
+#include <memory>
 
 // Concept to ensure that the type T is copyable
 template <typename T>
@@ -15,60 +17,236 @@ concept Copyable = std::is_copy_constructible_v<T> && std::is_copy_assignable_v<
 template <typename T>
 concept MoveAble = std::is_move_constructible_v<T> && std::is_move_assignable_v<T>;
 
-template <typename T>
+// Storage comes from Allocator (see allocators.h for an arena and a pool).
+// Only the first getSize() slots hold constructed elements; the rest of the
+// capacity is raw storage. Trivially copyable elements move with memcpy.
+template <typename T, typename Allocator = std::allocator<T>>
 class Vector {
 private:
+    using alloc_traits = std::allocator_traits<Allocator>;
+
+    [[no_unique_address]] Allocator alloc;
     T* data;
     size_t size;
     size_t capacity;
 
+    T* allocate(size_t n) {
+        return n == 0 ? nullptr : alloc_traits::allocate(alloc, n);
+    }
+
+    void deallocate(T* p, size_t n) noexcept {
+        if (p) {
+            alloc_traits::deallocate(alloc, p, n);
+        }
+    }
+
+    void destroy_elements(T* first, T* last) noexcept {
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            for (; first != last; ++first) {
+                alloc_traits::destroy(alloc, first);
+            }
+        }
+    }
+
+    // Copies [first, first + n) into raw storage at dest
+    void copy_elements(const T* first, size_t n, T* dest) {
+        if constexpr (std::is_trivially_copyable_v<T>) {
+            if (n != 0) {
+                std::memcpy(dest, first, n * sizeof(T));
+            }
+        } else {
+            size_t i = 0;
+            try {
+                for (; i < n; ++i) {
+                    alloc_traits::construct(alloc, dest + i, first[i]);
+                }
+            } catch (...) {
+                destroy_elements(dest, dest + i);
+                throw;
+            }
+        }
+    }
+
+    // Moves the elements into raw storage at dest and ends their lifetime
+    // here; copies instead of moving when the move could throw, so a failure
+    // leaves the vector as it was
+    void relocate_elements(T* dest) {
+        if constexpr (std::is_trivially_copyable_v<T>) {
+            if (size != 0) {
+                std::memcpy(dest, data, size * sizeof(T));
+            }
+        } else {
+            size_t i = 0;
+            try {
+                for (; i < size; ++i) {
+                    alloc_traits::construct(alloc, dest + i, std::move_if_noexcept(data[i]));
+                }
+            } catch (...) {
+                destroy_elements(dest, dest + i);
+                throw;
+            }
+            destroy_elements(data, data + size);
+        }
+    }
+
+    // Moves the elements to new storage of new_capacity in one step
+    void reallocate(size_t new_capacity) {
+        T* new_data = allocate(new_capacity);
+        try {
+            relocate_elements(new_data);
+        } catch (...) {
+            deallocate(new_data, new_capacity);
+            throw;
+        }
+        deallocate(data, capacity);
+        data = new_data;
+        capacity = new_capacity;
+    }
+
+    size_t grown_capacity(size_t min_capacity) const {
+        return std::max(min_capacity, capacity == 0 ? size_t(1) : capacity * 2);
+    }
+
+    // emplace_back when full: the new element is built before the old ones
+    // move, so args may refer into this vector
+    template <typename... Args>
+    T& emplace_back_grow(Args&&... args) {
+        const size_t new_capacity = grown_capacity(size + 1);
+        T* new_data = allocate(new_capacity);
+        try {
+            alloc_traits::construct(alloc, new_data + size, std::forward<Args>(args)...);
+        } catch (...) {
+            deallocate(new_data, new_capacity);
+            throw;
+        }
+        try {
+            relocate_elements(new_data);
+        } catch (...) {
+            alloc_traits::destroy(alloc, new_data + size);
+            deallocate(new_data, new_capacity);
+            throw;
+        }
+        deallocate(data, capacity);
+        data = new_data;
+        capacity = new_capacity;
+        return data[size++];
+    }
+
+    void release() noexcept {
+        destroy_elements(data, data + size);
+        deallocate(data, capacity);
+        data = nullptr;
+        size = 0;
+        capacity = 0;
+    }
+
 public:
+    using allocator_type = Allocator;
+
     // Constructors
-    Vector() : data(nullptr), size(0), capacity(0) {}
-    explicit Vector(size_t initial_capacity) : data(new T[initial_capacity]), size(0), capacity(initial_capacity) {}
+    Vector() : alloc(), data(nullptr), size(0), capacity(0) {}
+    explicit Vector(const Allocator& allocator) : alloc(allocator), data(nullptr), size(0), capacity(0) {}
+    explicit Vector(size_t initial_capacity, const Allocator& allocator = Allocator())
+        : alloc(allocator), data(nullptr), size(0), capacity(0) {
+        data = allocate(initial_capacity);
+        capacity = initial_capacity;
+    }
 
-    // Variadic template constructor to support uniform initialization
+    // Variadic template constructor to support uniform initialization; it
+    // leaves copies, moves and the allocator constructors to their overloads
     template <typename... Args>
-    explicit Vector(Args&&... args) : data(new T[sizeof...(Args)]), size(sizeof...(Args)), capacity(sizeof...(Args)) {
-        size_t index = 0;
-        (void)std::initializer_list<int>{(data[index++] = std::forward<Args>(args), 0)...};
+        requires ((!std::is_same_v<std::remove_cvref_t<Args>, Allocator> && ...) &&
+                  (sizeof...(Args) != 1 || (!std::is_same_v<std::remove_cvref_t<Args>, Vector> && ...)))
+    explicit Vector(Args&&... args) : alloc(), data(nullptr), size(0), capacity(0) {
+        data = allocate(sizeof...(Args));
+        capacity = sizeof...(Args);
+        try {
+            (emplace_back(std::forward<Args>(args)), ...);
+        } catch (...) {
+            release();
+            throw;
+        }
     }
 
     // Destructor
     ~Vector() {
-        delete[] data;
+        release();
     }
 
     // Copy constructor and assignment operator
-    Vector(const Vector& other) : data(new T[other.capacity]), size(other.size), capacity(other.capacity) {
-        for (size_t i = 0; i < size; ++i) {
-            data[i] = other.data[i];
+    Vector(const Vector& other)
+        : alloc(alloc_traits::select_on_container_copy_construction(other.alloc)),
+          data(nullptr), size(0), capacity(0) {
+        data = allocate(other.capacity);
+        capacity = other.capacity;
+        try {
+            copy_elements(other.data, other.size, data);
+        } catch (...) {
+            release();
+            throw;
         }
+        size = other.size;
     }
 
     Vector& operator=(const Vector& other) {
         if (this != &other) {
-            delete[] data;
-            data = new T[other.capacity];
-            size = other.size;
-            capacity = other.capacity;
-            for (size_t i = 0; i < size; ++i) {
-                data[i] = other.data[i];
+            const bool same_storage = !alloc_traits::propagate_on_container_copy_assignment::value ||
+                                      alloc == other.alloc;
+            if (same_storage && other.size <= capacity) {
+                // Reuse the storage; the copy is not rolled back if it throws
+                destroy_elements(data, data + size);
+                size = 0;
+                copy_elements(other.data, other.size, data);
+                size = other.size;
+                return *this;
             }
+            release();
+            if constexpr (alloc_traits::propagate_on_container_copy_assignment::value) {
+                alloc = other.alloc;
+            }
+            data = allocate(other.capacity);
+            capacity = other.capacity;
+            copy_elements(other.data, other.size, data);
+            size = other.size;
         }
         return *this;
     }
 
     // Move constructor and assignment operator
-    Vector(Vector&& other) noexcept : data(other.data), size(other.size), capacity(other.capacity) {
+    Vector(Vector&& other) noexcept
+        : alloc(std::move(other.alloc)), data(other.data), size(other.size), capacity(other.capacity) {
         other.data = nullptr;
         other.size = 0;
         other.capacity = 0;
     }
 
-    Vector& operator=(Vector&& other) noexcept {
+    // With an allocator that neither propagates nor compares equal, the
+    // storage cannot change hands and the elements are moved one by one
+    Vector& operator=(Vector&& other) noexcept(alloc_traits::propagate_on_container_move_assignment::value ||
+                                               alloc_traits::is_always_equal::value) {
         if (this != &other) {
-            delete[] data;
+            if constexpr (!alloc_traits::propagate_on_container_move_assignment::value &&
+                          !alloc_traits::is_always_equal::value) {
+                if (!(alloc == other.alloc)) {
+                    destroy_elements(data, data + size);
+                    size = 0;
+                    if (other.size > capacity) {
+                        deallocate(data, capacity);
+                        data = nullptr;
+                        capacity = 0;
+                        data = allocate(other.capacity);
+                        capacity = other.capacity;
+                    }
+                    for (; size < other.size; ++size) {
+                        alloc_traits::construct(alloc, data + size, std::move(other.data[size]));
+                    }
+                    return *this;
+                }
+            }
+            release();
+            if constexpr (alloc_traits::propagate_on_container_move_assignment::value) {
+                alloc = std::move(other.alloc);
+            }
             data = other.data;
             size = other.size;
             capacity = other.capacity;
@@ -80,30 +258,54 @@ public:
     }
 
     // Template friend function to allow access to private members
-    template <typename U>
-    friend void swapElements(Vector<U>& v1, Vector<U>& v2, size_t index1, size_t index2);
+    template <typename U, typename A>
+    friend void swapElements(Vector<U, A>& v1, Vector<U, A>& v2, size_t index1, size_t index2);
 
     // Member functions
     size_t getSize() const { return size; }
     size_t getCapacity() const { return capacity; }
+    Allocator get_allocator() const { return alloc; }
+    T* getData() { return data; }
+    const T* getData() const { return data; }
 
-    void push_back(const T& value) {
+    template <typename... Args>
+    T& emplace_back(Args&&... args) {
         if (size == capacity) {
-            reserve(capacity == 0 ? 1 : capacity * 2);
+            return emplace_back_grow(std::forward<Args>(args)...);
         }
-        data[size++] = value;
+        alloc_traits::construct(alloc, data + size, std::forward<Args>(args)...);
+        return data[size++];
+    }
+
+    void push_back(const T& value) {
+        emplace_back(value);
+    }
+
+    void push_back(T&& value) {
+        emplace_back(std::move(value));
     }
 
     void reserve(size_t new_capacity) {
         if (new_capacity > capacity) {
-            T* new_data = new T[new_capacity];
-            for (size_t i = 0; i < size; ++i) {
-                new_data[i] = std::move(data[i]);
-            }
-            delete[] data;
-            data = new_data;
-            capacity = new_capacity;
+            reallocate(new_capacity);
+        }
+    }
+
+    // Sets the size to n without constructing the new elements, for buffers
+    // that are about to be written, such as compressor output. Shrinking
+    // just drops the tail.
+    void resize_uninitialized(size_t n)
+        requires std::is_trivially_default_constructible_v<T> && std::is_trivially_destructible_v<T>
+    {
+        if (n > capacity) {
+            reallocate(grown_capacity(n));
         }
+        size = n;
+    }
+
+    void clear() noexcept {
+        destroy_elements(data, data + size);
+        size = 0;
     }
 
     T& operator[](size_t index) {
@@ -122,7 +324,9 @@ public:
 };
 
 // Template friend function to swap elements in two vectors
-template <typename U>
-void swapElements(Vector<U>& v1, Vector<U>& v2, size_t index1, size_t index2) {
+template <typename U, typename A>
+void swapElements(Vector<U, A>& v1, Vector<U, A>& v2, size_t index1, size_t index2) {
     std::swap(v1[index1], v2[index2]);
 }
+
+#endif // VECTOR_H
@@ -0,0 +1,65 @@
+#ifndef EASY_COMPRESS_DLIB_DEADLINE_COMPRESSION_H
+#define EASY_COMPRESS_DLIB_DEADLINE_COMPRESSION_H
+
+#include "block_stream.h"
+#include "kernel_table.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+namespace easy_compress_dlib {
+
+// Per-kernel throughput estimates in bytes per second. Seeded from the built-in
+// metrics, refined by calibrate() on this machine and by observed block timings.
+class KernelThroughputTable {
+public:
+    KernelThroughputTable();
+
+    double get(int kernel_index) const;
+    void observe(int kernel_index, std::size_t bytes, std::chrono::nanoseconds elapsed);
+
+    // Time every kernel on a representative sample and replace the estimates
+    void calibrate(const std::string& sample);
+
+private:
+    std::array<std::atomic<double>, kernel_count> throughput_;
+};
+
+KernelThroughputTable& default_throughput_table();
+
+struct DeadlineOptions {
+    std::size_t block_size = default_block_size;
+    double safety_factor = 0.8;   // fraction of the remaining budget a plan may use
+};
+
+struct DeadlineReport {
+    int initial_kernel = 0;
+    int final_kernel = 0;
+    std::size_t downgrades = 0;
+    std::chrono::nanoseconds elapsed{0};
+};
+
+// Strongest kernel (lowest bpb for file_type) expected to compress input_size
+// bytes within budget, or the fastest kernel if none fits.
+// Throws std::invalid_argument for an unknown file type.
+int select_kernel_for_deadline(const std::string& file_type, std::size_t input_size,
+                               std::chrono::nanoseconds budget,
+                               const KernelThroughputTable& table = default_throughput_table());
+
+// Compress into a block stream, checking elapsed time after every block and
+// switching to a faster kernel for the remaining blocks when behind schedule.
+DeadlineReport compress_with_deadline(const std::string& input, std::string& output,
+                                      const std::string& file_type, std::chrono::nanoseconds deadline,
+                                      const DeadlineOptions& options = {});
+
+// File variant of compress_with_deadline; returns the initially selected kernel.
+// Decompress the result with easy_decompress_blocks.
+int easy_compress_with_deadline(const std::string& input_filepath, const std::string& output_filepath,
+                                const std::string& file_type, std::chrono::milliseconds deadline,
+                                const DeadlineOptions& options = {});
+
+} // namespace easy_compress_dlib
+
+#endif // EASY_COMPRESS_DLIB_DEADLINE_COMPRESSION_H
@@ -0,0 +1,123 @@
+#ifndef EASY_COMPRESS_DLIB_DEDUP_H
+#define EASY_COMPRESS_DLIB_DEDUP_H
+
+#include "chunker.h"
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace easy_compress_dlib {
+
+// Deduplicating compression
+//
+// Inputs are split into content-defined chunks. Each distinct chunk is
+// compressed once into a shared chunk store; an input compresses to a
+// container listing the chunks it is made of. Chunks already in the store
+// are not compressed again.
+//
+// Chunks are identified by their fingerprint, which is not cryptographic (see
+// chunker.h). A chunk is only reused when its raw size matches too, and with
+// DedupOptions::verify_stored only when its stored bytes do. Two different
+// chunks with one fingerprint cannot both be stored, so compress_dedup throws
+// std::runtime_error instead of writing a container that decodes wrongly.
+//
+// Chunk store file, append only:
+//
+//   "ECCS" | u8 version
+//   per chunk:  u64 fingerprint.low | u64 fingerprint.high | u32 raw_size |
+//               u8 kernel_index | u32 payload_size | payload
+//
+// Dedup container:
+//
+//   "ECDD" | u8 version | u64 total_size | u32 chunk_count
+//   per chunk:  u64 fingerprint.low | u64 fingerprint.high | u32 raw_size
+//
+// All integers are little endian.
+
+constexpr char chunk_store_magic[4] = {'E', 'C', 'C', 'S'};
+constexpr std::uint8_t chunk_store_version = 1;
+constexpr std::size_t chunk_record_header_size = 25;
+
+constexpr char dedup_container_magic[4] = {'E', 'C', 'D', 'D'};
+constexpr std::uint8_t dedup_container_version = 1;
+constexpr std::size_t dedup_reference_size = 20;
+
+class ChunkStore {
+public:
+    // Opens the store, creating it if needed. The index is rebuilt from the
+    // record headers; a truncated last record (an interrupted append) is cut
+    // off. Throws std::runtime_error if the file cannot be opened or is not a
+    // chunk store.
+    explicit ChunkStore(const std::string& filename);
+
+    ChunkStore(const ChunkStore&) = delete;
+    ChunkStore& operator=(const ChunkStore&) = delete;
+
+    bool contains(const ChunkFingerprint& fingerprint) const;
+    // Throws std::runtime_error if the stored chunk has another raw size,
+    // which means the fingerprints collide
+    bool contains(const ChunkFingerprint& fingerprint, std::size_t raw_size) const;
+
+    // Whether the stored chunk is exactly data; decompresses it
+    bool matches(const ChunkFingerprint& fingerprint, std::string_view data) const;
+
+    // Append a compressed chunk; returns false if it was already stored.
+    // Throws std::runtime_error if it was stored with another raw size.
+    bool put(const ChunkFingerprint& fingerprint, int kernel_index, std::size_t raw_size, std::string_view payload);
+
+    // Decompressed chunk. Throws std::runtime_error if it is not in the store.
+    std::string get(const ChunkFingerprint& fingerprint) const;
+
+    std::size_t size() const;
+
+private:
+    struct Location {
+        std::uint64_t payload_offset;
+        std::uint32_t payload_size;
+        std::uint32_t raw_size;
+        int kernel_index;
+    };
+
+    std::string filename_;
+    mutable std::mutex mutex_;
+    mutable std::fstream file_;
+    std::unordered_map<ChunkFingerprint, Location, ChunkFingerprintHash> index_;
+    std::uint64_t end_ = 0;
+};
+
+struct DedupOptions {
+    ChunkerOptions chunker;
+    unsigned threads = 0;   // 0 = hardware concurrency
+    // Decompress every chunk found in the store and compare it before reusing
+    // it. Costs a decode per reused chunk; meant for untrusted input.
+    bool verify_stored = false;
+};
+
+struct DedupReport {
+    std::size_t chunks = 0;
+    std::size_t new_chunks = 0;       // compressed and added to the store
+    std::uint64_t new_bytes = 0;      // raw bytes of the new chunks
+};
+
+// New chunks are compressed concurrently, each with the best kernel for its
+// classified type at the given alpha
+DedupReport compress_dedup(const std::string& input, std::string& output, ChunkStore& store, double alpha,
+                           const DedupOptions& options = {});
+
+// Throws std::runtime_error on a malformed container or a missing chunk, before
+// output grows; output is left as it was on any error
+void decompress_dedup(std::string_view container, const ChunkStore& store, std::string& output,
+                      unsigned threads = 1);
+
+DedupReport easy_compress_dedup(const std::string& input_filepath, const std::string& output_filepath,
+                                const std::string& store_filepath, double alpha, const DedupOptions& options = {});
+void easy_decompress_dedup(const std::string& input_filepath, const std::string& output_filepath,
+                           const std::string& store_filepath, unsigned threads = 1);
+
+} // namespace easy_compress_dlib
+
+#endif // EASY_COMPRESS_DLIB_DEDUP_H
@@ -0,0 +1,69 @@
+#ifndef EASY_COMPRESS_DLIB_DICTIONARY_H
+#define EASY_COMPRESS_DLIB_DICTIONARY_H
+
+#include "lz77_codec.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace easy_compress_dlib {
+
+// Pre-trained dictionaries for small messages
+//
+// A dictionary is a few KB of content typical of the messages: common keys,
+// tags and boilerplate. Compression starts from an LZ77 kernel whose history
+// already holds the dictionary, so even a 200 byte message can refer back into
+// it. Compressor and decompressor must use the same dictionary; id() is there
+// for callers that need to record which one was used.
+
+constexpr std::size_t default_dictionary_size = 16 * 1024;
+
+struct DictionaryTrainingOptions {
+    std::size_t max_size = default_dictionary_size;
+    std::size_t segment_size = 64;   // candidate pieces of the samples
+};
+
+// Pick the segments whose 8-byte substrings occur in the most samples, with the
+// most useful ones last so that they end up closest to the message
+std::string train_dictionary(const std::vector<std::string>& samples,
+                             const DictionaryTrainingOptions& options = {});
+
+// Train from every regular file under sample_dir. Throws std::runtime_error if
+// the directory cannot be read or holds no samples.
+std::string train_dictionary_from_directory(const std::string& sample_dir,
+                                            const DictionaryTrainingOptions& options = {});
+
+class Lz77Dictionary {
+public:
+    // Primes a snapshot kernel with content once; every call clones it
+    explicit Lz77Dictionary(std::string content);
+
+    Lz77Dictionary(const Lz77Dictionary&) = delete;
+    Lz77Dictionary& operator=(const Lz77Dictionary&) = delete;
+
+    const std::string& content() const { return content_; }
+    std::uint32_t id() const { return id_; }
+
+    // Thread safe; each thread reuses one working kernel. The output is the
+    // varint size of input followed by LZ77 tokens.
+    void compress(const std::string& input, std::string& output) const;
+    // Decodes no more than the recorded size; throws std::runtime_error on a
+    // malformed message
+    void decompress(const std::string& input, std::string& output) const;
+
+    // Dictionaries are stored as their raw content
+    static std::unique_ptr<Lz77Dictionary> load(const std::string& filename);
+    void save(const std::string& filename) const;
+
+private:
+    std::string content_;
+    std::uint32_t id_;
+    unsigned long total_limit_;
+    std::unique_ptr<lz77_kernel> snapshot_;
+};
+
+} // namespace easy_compress_dlib
+
+#endif // EASY_COMPRESS_DLIB_DICTIONARY_H
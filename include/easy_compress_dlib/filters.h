@@ -0,0 +1,63 @@
+#ifndef EASY_COMPRESS_DLIB_FILTERS_H
+#define EASY_COMPRESS_DLIB_FILTERS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace easy_compress_dlib {
+
+// Preprocessing filters
+//
+// Reversible transforms applied to a block before its kernel runs, so that
+// byte-oriented kernels see the data's correlations:
+//
+//   delta      out[i] = in[i] - in[i - distance]         numeric series
+//   transpose  gather byte k of every stride-byte record  fixed-size records
+//   x86_bcj    relative E8/E9 call targets made absolute executables
+//
+// A filtered block payload starts with its chain:
+//
+//   u8 step_count | per step: u8 filter_id | u8 parameter
+//
+// Steps are applied in order when compressing and inverted in reverse order
+// when decompressing.
+
+enum class FilterId : std::uint8_t { delta = 1, transpose = 2, x86_bcj = 3 };
+
+struct FilterStep {
+    FilterId id;
+    std::uint8_t parameter;   // delta distance or transpose stride; unused by x86_bcj
+};
+
+using FilterChain = std::vector<FilterStep>;
+
+constexpr std::size_t max_filter_steps = 4;
+constexpr std::size_t max_record_stride = 32;
+
+// Throw std::invalid_argument for an invalid step
+void apply_filter(const FilterStep& step, std::string_view input, std::string& output);
+void invert_filter(const FilterStep& step, std::string_view input, std::string& output);
+
+// Whole chains, ping-ponging between two buffers; an empty chain copies
+void apply_filters(const FilterChain& chain, std::string_view input, std::string& output);
+void invert_filters(const FilterChain& chain, std::string_view input, std::string& output);
+
+void put_filter_header(std::string& out, const FilterChain& chain);
+// Reads the chain and removes it from the front of payload. Throws
+// std::runtime_error on a malformed header.
+FilterChain read_filter_header(std::string_view& payload);
+
+// Record length with the strongest autocorrelation: the stride s for which
+// data[i] == data[i - s] most often, if it clearly beats neighbouring bytes
+// (s = 1). Returns 1 when there is no such stride.
+std::size_t detect_record_stride(std::string_view data, std::size_t max_stride = max_record_stride);
+
+// Pick filters for a block from a sample of it; empty when none is likely to help
+FilterChain choose_filters(std::string_view data);
+
+} // namespace easy_compress_dlib
+
+#endif // EASY_COMPRESS_DLIB_FILTERS_H
@@ -0,0 +1,149 @@
+#ifndef EASY_COMPRESS_DLIB_HW_PROFILER_H
+#define EASY_COMPRESS_DLIB_HW_PROFILER_H
+
+#include "metrics.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace easy_compress_dlib {
+
+// Hardware counter profiling
+//
+// Each thread opens one perf_event_open counter group (user space only) the
+// first time it reads counters: cycles, instructions, cache references and
+// misses, branches and branch misses. Events the CPU or kernel refuses are
+// left out, and where perf_event_open is not allowed at all, as in most
+// containers, readings carry wall-clock time only.
+//
+// In profiling mode, off by default, ProfileScope accumulates a reading per
+// region: each codec's compress and decompress calls, and inside the LZ77
+// parsers the whole parse, find_match and shift_buffers. Regions nest, so the
+// parse includes its find_match calls. find_match is charged the input it
+// consumes, the match or the one literal that follows a miss, so per-byte
+// costs add up over the parse. Reading counters costs a system call, so
+// profiling slows the finer regions down several times; compare per-byte
+// costs between runs made the same way. Builds with
+// EASY_COMPRESS_DLIB_DISABLE_METRICS compile the scopes away.
+
+enum class HardwareEvent { cycles, instructions, cache_references, cache_misses, branches, branch_misses };
+constexpr std::size_t hardware_event_count = 6;
+
+const char* hardware_event_name(HardwareEvent event);
+
+struct CounterReading {
+    double seconds = 0.0;
+    std::array<std::uint64_t, hardware_event_count> events{};
+    std::uint32_t available = 0;   // bit (1 << event) for every event counted
+
+    bool has(HardwareEvent event) const { return available & (1u << static_cast<unsigned>(event)); }
+    std::uint64_t get(HardwareEvent event) const { return events[static_cast<std::size_t>(event)]; }
+    // Instructions per cycle, 0 unless both were counted
+    double ipc() const;
+
+    // Events missing from either side are dropped
+    CounterReading& operator+=(const CounterReading& other);
+};
+
+// Counts for the calling thread since its group was opened; seconds are
+// steady_clock time. The difference of two readings covers what ran between.
+CounterReading read_thread_counters();
+CounterReading operator-(const CounterReading& end, const CounterReading& start);
+
+// Whether the calling thread got at least one hardware event
+bool hardware_counters_available();
+
+// Profile regions
+enum class ProfileRegion { lz77_parse = 0, find_match = 1, shift_buffer = 2 };
+constexpr std::size_t fixed_profile_regions = 3;
+constexpr std::size_t profile_region_count = fixed_profile_regions + codec_count * kernel_operation_count;
+
+inline std::size_t profile_region(ProfileRegion region) {
+    return static_cast<std::size_t>(region);
+}
+
+// Region of a codec's compress or decompress calls
+inline std::size_t profile_region(int codec_index, KernelOperation operation) {
+    return fixed_profile_regions + static_cast<std::size_t>(codec_index - 1) * kernel_operation_count +
+           static_cast<std::size_t>(operation);
+}
+
+// "find_match", "compress_kernel_1a", "decompress_kernel_lz77", ...
+std::string profile_region_name(std::size_t region);
+
+struct RegionProfile {
+    std::string name;
+    std::uint64_t calls = 0;
+    std::uint64_t bytes = 0;   // input bytes, for the regions that know them
+    CounterReading counters;
+
+    // Per input byte, 0 without bytes or without the event
+    double per_byte(HardwareEvent event) const;
+    double nanoseconds_per_byte() const;
+};
+
+void set_profiling(bool enabled);
+
+namespace profile_detail {
+
+inline std::atomic<bool> profiling{false};
+
+void add_sample(std::size_t region, std::uint64_t bytes, const CounterReading& start);
+
+} // namespace profile_detail
+
+inline bool profiling_enabled() {
+    return metrics_enabled && profile_detail::profiling.load(std::memory_order_relaxed);
+}
+
+// Regions with at least one call since startup or the last reset_profile
+std::vector<RegionProfile> collect_profile();
+void reset_profile();
+
+// Table with one row per region: calls, bytes, ns/byte, cycles/byte, IPC,
+// cache misses and branch misses per KB; "-" for events not counted
+std::string profile_report(const std::vector<RegionProfile>& profile);
+
+// Adds the reading between construction and destruction to a region, when
+// profiling is on
+class ProfileScope {
+public:
+    explicit ProfileScope([[maybe_unused]] std::size_t region, [[maybe_unused]] std::uint64_t bytes = 0) {
+        if constexpr (metrics_enabled) {
+            if (profiling_enabled()) {
+                active_ = true;
+                region_ = region;
+                bytes_ = bytes;
+                start_ = read_thread_counters();
+            }
+        }
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+    // For regions that learn their size as they run
+    void set_bytes(std::uint64_t bytes) { bytes_ = bytes; }
+
+    ~ProfileScope() {
+        if constexpr (metrics_enabled) {
+            if (active_) {
+                profile_detail::add_sample(region_, bytes_, start_);
+            }
+        }
+    }
+
+private:
+    bool active_ = false;
+    std::size_t region_ = 0;
+    std::uint64_t bytes_ = 0;
+    CounterReading start_;
+};
+
+} // namespace easy_compress_dlib
+
+#endif // EASY_COMPRESS_DLIB_HW_PROFILER_H
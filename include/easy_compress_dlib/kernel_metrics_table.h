@@ -0,0 +1,173 @@
+#ifndef EASY_COMPRESS_DLIB_KERNEL_METRICS_TABLE_H
+#define EASY_COMPRESS_DLIB_KERNEL_METRICS_TABLE_H
+
+#include "kernel_table.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+namespace easy_compress_dlib {
+
+// File types covered by the built-in metrics, in table order
+enum class FileTypeId : std::uint8_t { text, play, html, Csrc, list, Excl, tech, poem, fax, SPRC, man };
+
+constexpr std::size_t file_type_count = 11;
+
+constexpr std::array<std::string_view, file_type_count> known_file_types = {
+    "text", "play", "html", "Csrc", "list", "Excl", "tech", "poem", "fax", "SPRC", "man"
+};
+
+// Compile-time perfect hash from file type names to FileTypeId
+
+constexpr std::uint32_t file_type_hash(std::string_view name, std::uint32_t seed) {
+    std::uint32_t hash = 2166136261u ^ seed;   // FNV-1a
+    for (char c : name) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+constexpr std::size_t file_type_hash_slots = 32;
+
+// Smallest seed for which every known file type lands in its own slot
+constexpr std::uint32_t find_file_type_hash_seed() {
+    for (std::uint32_t seed = 0;; ++seed) {
+        std::array<bool, file_type_hash_slots> used{};
+        bool collision = false;
+        for (auto name : known_file_types) {
+            auto slot = file_type_hash(name, seed) % file_type_hash_slots;
+            collision = collision || used[slot];
+            used[slot] = true;
+        }
+        if (!collision) {
+            return seed;
+        }
+    }
+}
+
+constexpr std::uint32_t file_type_hash_seed = find_file_type_hash_seed();
+
+constexpr std::array<std::int8_t, file_type_hash_slots> file_type_hash_table = [] {
+    std::array<std::int8_t, file_type_hash_slots> table{};
+    for (auto& slot : table) {
+        slot = -1;
+    }
+    for (std::size_t i = 0; i < file_type_count; ++i) {
+        table[file_type_hash(known_file_types[i], file_type_hash_seed) % file_type_hash_slots] = static_cast<std::int8_t>(i);
+    }
+    return table;
+}();
+
+constexpr std::optional<FileTypeId> parse_file_type(std::string_view name) {
+    auto index = file_type_hash_table[file_type_hash(name, file_type_hash_seed) % file_type_hash_slots];
+    if (index < 0 || known_file_types[index] != name) {
+        return std::nullopt;
+    }
+    return static_cast<FileTypeId>(index);
+}
+
+// Position of file_type in known_file_types, or -1
+constexpr int file_type_index(std::string_view file_type) {
+    auto id = parse_file_type(file_type);
+    return id ? static_cast<int>(*id) : -1;
+}
+
+static_assert(parse_file_type("Csrc") == FileTypeId::Csrc);
+static_assert(!parse_file_type("csrc").has_value());
+
+// Kernel metrics: bits per byte per file type, and compression time (ms) over the corpus
+template <std::size_t N>
+struct KernelMetrics {
+    std::array<double, N> bpbs;
+    double compression_time;
+
+    constexpr double bpb(FileTypeId type) const { return bpbs[static_cast<std::size_t>(type)]; }
+};
+
+// Metrics for every kernel, indexed by kernel_index - 1
+using KernelMetricsSet = std::array<KernelMetrics<file_type_count>, kernel_count>;
+
+// Built-in metrics; columns follow known_file_types
+//              text     play     html     Csrc     list     Excl      tech     poem     fax       SPRC     man
+constexpr KernelMetricsSet kernel_metrics_table = {{
+    /* 1a  */ {{4.576,   4.82062, 5.27058, 5.08269, 4.78151, 3.42421,  4.65552, 4.53897, 1.16966,  5.3682,  5.03998}, 875},
+    /* 1b  */ {{3.48033, 3.48761, 3.79173, 3.39587, 3.50228, 2.66821,  3.5305,  3.39085, 0.843731, 3.82992, 3.97445}, 844},
+    /* 1c  */ {{2.72525, 2.8121,  2.79706, 2.43874, 2.73475, 1.84252,  2.75737, 2.82208, 0.845336, 3.17782, 3.33665}, 1031},
+    /* 1da */ {{2.39754, 2.71176, 2.51839, 2.27085, 2.66165, 1.51397,  2.09653, 2.45897, 0.874096, 2.98075, 3.28555}, 1812},
+    /* 1db */ {{2.51658, 2.88029, 2.57334, 2.35265, 2.7541,  1.6337,   2.17129, 2.61234, 0.880362, 3.02636, 3.36882}, 2296},
+    /* 1ea */ {{2.14059, 2.39152, 2.2303,  2.00323, 2.33056, 1.21892,  1.9272,  2.26894, 0.796686, 2.63389, 2.89567}, 3062},
+    /* 1eb */ {{2.1156,  2.39344, 2.21729, 1.98744, 2.33271, 1.23088,  1.87917, 2.26042, 0.785229, 2.59142, 2.89189}, 4875},
+    /* 1ec */ {{2.12334, 2.41478, 2.22022, 1.94439, 2.33056, 1.26447,  1.88376, 2.30955, 0.783701, 2.55628, 2.90135}, 5484},
+    /* 2a  */ {{2.9275,  3.17293, 2.71349, 2.52126, 2.96479, 0.564156, 2.72575, 3.25586, 0.775346, 2.77259, 3.51455}, 4641},
+    /* 3a  */ {{6.2395,  6.63121, 4.57408, 4.16502, 4.60521, 3.03748,  5.81782, 7.22449, 1.81285,  4.82762, 6.01278}, 547},
+    /* 3b  */ {{5.86693, 6.48396, 4.52433, 4.13274, 4.64391, 3.16557,  5.46419, 6.93805, 1.77918,  4.85021, 5.97871}, 734}
+}};
+
+// Select the best 1-based kernel index for a file type. Both the ratio and the
+// speed term are relative to the average over all kernels, weighted by alpha.
+constexpr int select_best_kernel(const KernelMetricsSet& metrics, FileTypeId type, double alpha) {
+    double avg_bpb = 0.0;
+    double avg_compression_time = 0.0;
+    for (const auto& kernel : metrics) {
+        avg_bpb += kernel.bpb(type);
+        avg_compression_time += kernel.compression_time;
+    }
+    avg_bpb /= metrics.size();
+    avg_compression_time /= metrics.size();
+
+    int best_kernel = 0;
+    double best_measure = 0.0;
+    for (std::size_t k = 0; k < metrics.size(); ++k) {
+        const auto& kernel = metrics[k];
+        double compression_ratio = avg_bpb / kernel.bpb(type);
+        double time_factor = avg_compression_time / kernel.compression_time;
+        double performance_measure = alpha * compression_ratio + (1 - alpha) * time_factor;
+        if (k == 0 || performance_measure > best_measure) {
+            best_measure = performance_measure;
+            best_kernel = static_cast<int>(k);
+        }
+    }
+    return best_kernel + 1;
+}
+
+constexpr int select_best_kernel(FileTypeId type, double alpha) {
+    return select_best_kernel(kernel_metrics_table, type, alpha);
+}
+
+// Precomputed selections for alpha quantized to steps of 1 / (alpha_buckets - 1)
+constexpr std::size_t alpha_buckets = 101;
+
+constexpr std::size_t alpha_bucket(double alpha) {
+    if (!(alpha > 0.0)) {   // also catches NaN
+        return 0;
+    }
+    if (alpha >= 1.0) {
+        return alpha_buckets - 1;
+    }
+    return static_cast<std::size_t>(alpha * (alpha_buckets - 1) + 0.5);
+}
+
+constexpr auto kernel_selection_table = [] {
+    std::array<std::array<std::uint8_t, alpha_buckets>, file_type_count> table{};
+    for (std::size_t t = 0; t < file_type_count; ++t) {
+        for (std::size_t b = 0; b < alpha_buckets; ++b) {
+            double alpha = static_cast<double>(b) / (alpha_buckets - 1);
+            table[t][b] = static_cast<std::uint8_t>(select_best_kernel(static_cast<FileTypeId>(t), alpha));
+        }
+    }
+    return table;
+}();
+
+// Hot-path selection: a single table load
+constexpr int lookup_best_kernel(FileTypeId type, double alpha) {
+    return kernel_selection_table[static_cast<std::size_t>(type)][alpha_bucket(alpha)];
+}
+
+static_assert(lookup_best_kernel(FileTypeId::text, 0.0) == select_best_kernel(FileTypeId::text, 0.0));
+
+} // namespace easy_compress_dlib
+
+#endif // EASY_COMPRESS_DLIB_KERNEL_METRICS_TABLE_H
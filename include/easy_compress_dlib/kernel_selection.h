@@ -1,7 +1,11 @@
 #ifndef EASY_COMPRESS_DLIB_KERNEL_SELECTION_H
 #define EASY_COMPRESS_DLIB_KERNEL_SELECTION_H
 
+#include "kernel_metrics_table.h"
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <concepts>
 
@@ -32,6 +36,42 @@ template <typename KernelContainer>
 requires std::ranges::range<KernelContainer>
 auto select_best_kernel(const KernelContainer& kernels, const CompressionMetrics& metrics, double alpha);
 
+// Size of the corpus the built-in metrics were measured on
+constexpr std::size_t metrics_corpus_size = 2810784;
+
+// Active metrics: the built-in kernel_metrics_table until reloaded. Every
+// reload gets a new version, which invalidates memoized selections; the
+// built-in table is always version 0, also after reset_kernel_metrics. A
+// replaced set lives on while a caller still holds it.
+std::shared_ptr<const KernelMetricsSet> current_kernel_metrics();
+std::uint32_t kernel_metrics_version();
+
+// Hash of the active metrics values. Versions only order reloads within one
+// process; the fingerprint is what files record, since it is the same in any
+// process that loaded the same metrics.
+std::uint64_t kernel_metrics_fingerprint();
+void set_kernel_metrics(const KernelMetricsSet& metrics);
+void reset_kernel_metrics();
+
+// CSV rows: kernel_index,file_type,bpb,compression_time_ms. Rows override the
+// built-in values; kernels and types that are not listed keep them.
+void reload_kernel_metrics(const std::string& filename);
+
+// Metrics lookups by 1-based kernel index (see kernel_table.h)
+double get_kernel_bpb(int kernel_index, const std::string& file_type);  // -1 if file type unknown
+double get_kernel_throughput(int kernel_index);                         // bytes per second
+
+// Best 1-based kernel index for a file type, trading ratio against speed by alpha.
+// Alpha is quantized to the buckets of kernel_selection_table; an unknown file type selects kernel 1.
+// With the built-in metrics this is a load from kernel_selection_table, after a
+// reload it goes through a KernelSelectionCache.
+int select_kernel(std::string_view file_type, double alpha);
+
+template <typename FileType, typename Alpha>
+int kernel_selection(const FileType& file_type, Alpha alpha) {
+    return select_kernel(std::string_view(file_type), static_cast<double>(alpha));
+}
+
 } // namespace easy_compress_dlib
 
 #endif // EASY_COMPRESS_DLIB_KERNEL_SELECTION_H
@@ -0,0 +1,51 @@
+#ifndef EASY_COMPRESS_DLIB_KERNEL_TABLE_H
+#define EASY_COMPRESS_DLIB_KERNEL_TABLE_H
+
+#include <cstddef>
+#include <string>
+
+namespace easy_compress_dlib {
+
+// Signature shared by every compress_kernel_* / decompress_kernel_* wrapper
+using kernel_function = void (*)(const std::string& input, std::string& output);
+
+// Decompressors of the table also get the most output the caller expects. The
+// LZ77 format does not end on its own terms, so its decoder stops there; the
+// dlib formats do and are checked afterwards.
+using decompress_function = void (*)(const std::string& input, std::string& output, std::size_t max_size);
+
+// One entry per compression kernel. Kernel indices are 1-based and follow the
+// order of the metrics tables in kernel_selection.cpp, the same numbering used
+// by map_kernel_and_compress.
+struct KernelEntry {
+    const char* name;
+    kernel_function compress;
+    decompress_function decompress;
+};
+
+// Kernels with metrics, the ones kernel selection chooses from
+constexpr int kernel_count = 11;
+
+// In-tree LZ77 token codec (lz77_codec.h). It has no metrics yet, so it is
+// never selected, but it can be named explicitly and appear in block streams.
+constexpr int lz77_kernel_index = kernel_count + 1;
+constexpr int codec_count = lz77_kernel_index;
+
+bool is_valid_kernel_index(int kernel_index);
+bool is_valid_codec_index(int codec_index);
+
+// Throws std::out_of_range for an invalid kernel index
+const KernelEntry& get_kernel_entry(int kernel_index);
+
+// Same, for any codec index including lz77_kernel_index
+const KernelEntry& get_codec_entry(int codec_index);
+
+// These take codec indices. decompress_with_kernel throws std::runtime_error
+// if the output would exceed max_size bytes.
+void compress_with_kernel(int kernel_index, const std::string& input, std::string& output);
+void decompress_with_kernel(int kernel_index, const std::string& input, std::string& output,
+                            std::size_t max_size);
+
+} // namespace easy_compress_dlib
+
+#endif // EASY_COMPRESS_DLIB_KERNEL_TABLE_H
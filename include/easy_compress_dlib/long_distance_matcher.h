@@ -0,0 +1,42 @@
+#ifndef EASY_COMPRESS_DLIB_LONG_DISTANCE_MATCHER_H
+#define EASY_COMPRESS_DLIB_LONG_DISTANCE_MATCHER_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace easy_compress_dlib {
+
+// Long-distance matching
+//
+// The LZ77 window is 2^lz77_total_limit bytes, so content repeated megabytes
+// apart is never matched. The long-distance matcher looks at the whole input
+// through sparse anchors: positions where a rolling hash of the last 64 bytes
+// has its top anchor_log bits clear, one every 2^anchor_log bytes on average.
+// Only anchors are stored, as u32 positions in a table with about one slot per
+// anchor, so memory is about 4 bytes per 2^anchor_log bytes of input.
+
+struct LdmOptions {
+    unsigned anchor_log = 10;             // one anchor per KB: ~4 bytes of table per KB of input
+    std::size_t min_match_length = 64;
+};
+
+struct LdmMatch {
+    std::size_t position;   // start in the input
+    std::size_t length;
+    std::size_t distance;   // bytes back from position
+};
+
+// Non-overlapping matches in increasing position order. Throws
+// std::invalid_argument for inputs of 4 GB or more.
+std::vector<LdmMatch> find_long_distance_matches(std::string_view input, const LdmOptions& options = {});
+
+// LZ77 with the long-distance matches taken first and the normal parser run on
+// the gaps between them. The output is an ordinary LZ77 token stream, decoded
+// by decompress_lz77.
+void compress_lz77_ldm(std::string_view input, std::string& output, const LdmOptions& options = {});
+
+} // namespace easy_compress_dlib
+
+#endif // EASY_COMPRESS_DLIB_LONG_DISTANCE_MATCHER_H
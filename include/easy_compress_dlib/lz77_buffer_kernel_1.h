@@ -3,6 +3,7 @@
 
 #include "lz77_buffer_kernel_abstract.h"
 #include "../algs.h"
+#include "lz77_buffer_policies.h"
 
 
 
@@ -10,7 +11,11 @@ namespace dlib
 {
 
     template <
-        typename sliding_buffer
+        typename sliding_buffer,
+        typename checking = lz77_no_checks,
+        typename stats = lz77_metrics_stats,
+        typename tracing = lz77_no_tracing,
+        typename allocator = std::allocator<char>
         >
     class lz77_buffer_kernel_1 
     {
@@ -19,7 +24,8 @@ namespace dlib
 
         lz77_buffer_kernel_1 (
             unsigned long total_limit_,
-            unsigned long lookahead_limit_  
+            unsigned long lookahead_limit_,
+            const allocator& alloc_ = allocator()
         );
 
         virtual ~lz77_buffer_kernel_1 (
@@ -52,19 +58,47 @@ namespace dlib
 
         inline unsigned char lookahead_buffer (
             unsigned long index
-        ) const { return buffer[lookahead_limit-1-index]; }
+        ) const
+        {
+            checking::check_lookahead_index(this, index, lookahead_size);
+            return lookahead_at(index);
+        }
 
         inline unsigned char history_buffer (
             unsigned long index
-        ) const { return buffer[lookahead_limit+index]; }
+        ) const
+        {
+            checking::check_history_index(this, index, history_size);
+            return history_at(index);
+        }
 
 
         inline void shift_buffers (
             unsigned long N
-        ) { shift_buffer(N); }
+        )
+        {
+            checking::check_shift(this, N, lookahead_size);
+            tracer.on_shift(N);
+            shift_buffer(N);
+        }
+
+        inline tracing& get_tracer (
+        ) { return tracer; }
+
+        inline const tracing& get_tracer (
+        ) const { return tracer; }
 
     private:
 
+        // unchecked accessors for the kernel's own use
+        inline unsigned char lookahead_at (
+            unsigned long index
+        ) const { return buffer[lookahead_limit-1-index]; }
+
+        inline unsigned char history_at (
+            unsigned long index
+        ) const { return buffer[lookahead_limit+index]; }
+
 
         inline void shift_buffer (
             unsigned long N
@@ -89,10 +123,12 @@ namespace dlib
         unsigned long lookahead_size;
         unsigned long history_size;
 
+        [[no_unique_address]] tracing tracer;
+
 
         // restricted functions
-        lz77_buffer_kernel_1(lz77_buffer_kernel_1<sliding_buffer>&);        // copy constructor
-        lz77_buffer_kernel_1<sliding_buffer>& operator=(lz77_buffer_kernel_1<sliding_buffer>&);    // assignment operator
+        lz77_buffer_kernel_1(lz77_buffer_kernel_1<sliding_buffer,checking,stats,tracing,allocator>&);        // copy constructor
+        lz77_buffer_kernel_1<sliding_buffer,checking,stats,tracing,allocator>& operator=(lz77_buffer_kernel_1<sliding_buffer,checking,stats,tracing,allocator>&);    // assignment operator
     };   
 
 // ----------------------------------------------------------------------------------------
@@ -102,16 +138,23 @@ namespace dlib
 // ----------------------------------------------------------------------------------------
     
     template <
-        typename sliding_buffer
+        typename sliding_buffer,
+        typename checking,
+        typename stats,
+        typename tracing,
+        typename allocator
         >
-    lz77_buffer_kernel_1<sliding_buffer>::
+    lz77_buffer_kernel_1<sliding_buffer,checking,stats,tracing,allocator>::
     lz77_buffer_kernel_1 (
         unsigned long total_limit_,
-        unsigned long lookahead_limit_  
+        unsigned long lookahead_limit_,
+        const allocator& alloc_
     ) :        
+        buffer(lz77_make_sliding_buffer<sliding_buffer>(alloc_)),
         lookahead_size(0), 
         history_size(0)
     {
+        checking::check_limits(total_limit_, lookahead_limit_);
         buffer.set_size(total_limit_);
         lookahead_limit = lookahead_limit_;
         history_limit = buffer.size() - lookahead_limit_;
@@ -120,9 +163,13 @@ namespace dlib
 // ----------------------------------------------------------------------------------------
     
     template <
-        typename sliding_buffer
+        typename sliding_buffer,
+        typename checking,
+        typename stats,
+        typename tracing,
+        typename allocator
         >
-    void lz77_buffer_kernel_1<sliding_buffer>::
+    void lz77_buffer_kernel_1<sliding_buffer,checking,stats,tracing,allocator>::
     clear(
     )
     {
@@ -133,13 +180,18 @@ namespace dlib
 // ----------------------------------------------------------------------------------------
     
     template <
-        typename sliding_buffer
+        typename sliding_buffer,
+        typename checking,
+        typename stats,
+        typename tracing,
+        typename allocator
         >
-    void lz77_buffer_kernel_1<sliding_buffer>::
+    void lz77_buffer_kernel_1<sliding_buffer,checking,stats,tracing,allocator>::
     add (
         unsigned char symbol
     )
     {
+        tracer.on_add(symbol);
         if (lookahead_size == lookahead_limit)
         {
             shift_buffer(1);            
@@ -151,15 +203,20 @@ namespace dlib
 // ----------------------------------------------------------------------------------------
     
     template <
-        typename sliding_buffer
+        typename sliding_buffer,
+        typename checking,
+        typename stats,
+        typename tracing,
+        typename allocator
         >
-    void lz77_buffer_kernel_1<sliding_buffer>::
+    void lz77_buffer_kernel_1<sliding_buffer,checking,stats,tracing,allocator>::
     find_match (
         unsigned long& index,
         unsigned long& length,
         unsigned long min_match_length
     )
     {
+        const unsigned long history_size_searched = history_size;
         unsigned long hpos = history_size;  // current position in the history buffer
         unsigned long lpos = 0;             // current position in the lookahead buffer
 
@@ -171,7 +228,7 @@ namespace dlib
         {
             --hpos;
             // if we are finding a match
-            if (history_buffer(hpos) == lookahead_buffer(lpos))
+            if (history_at(hpos) == lookahead_at(lpos))
             {
                 ++lpos;   
                 // if we have found a match that is as long as the lookahead buffer
@@ -212,6 +269,9 @@ namespace dlib
         {
             length = 0;
         }
+        // every history position is a candidate
+        stats::find_match(history_size_searched, length);
+        tracer.on_find_match(length != 0 ? index : 0, length);
     }
 
 // ----------------------------------------------------------------------------------------
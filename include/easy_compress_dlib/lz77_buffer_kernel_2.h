@@ -3,12 +3,18 @@
 
 #include "lz77_buffer_kernel_abstract.h"
 #include "../algs.h"
+#include "../assert.h"
+#include "lz77_buffer_policies.h"
 
 
 
 namespace dlib{
     template <
-        typename sliding_buffer
+        typename sliding_buffer,
+        typename checking = lz77_no_checks,
+        typename stats = lz77_metrics_stats,
+        typename tracing = lz77_no_tracing,
+        typename allocator = std::allocator<char>
         >
     class lz77_buffer_kernel_2 
     {
@@ -16,7 +22,8 @@ namespace dlib{
 
         lz77_buffer_kernel_2 (
             unsigned long total_limit_,
-            unsigned long lookahead_limit_  
+            unsigned long lookahead_limit_,
+            const allocator& alloc_ = allocator()
         );
 
         virtual ~lz77_buffer_kernel_2 (
@@ -49,19 +56,60 @@ namespace dlib{
 
         inline unsigned char lookahead_buffer (
             unsigned long index
-        ) const { return buffer[lookahead_limit-1-index]; }
+        ) const
+        {
+            checking::check_lookahead_index(this, index, lookahead_size);
+            return lookahead_at(index);
+        }
 
         inline unsigned char history_buffer (
             unsigned long index
-        ) const { return buffer[lookahead_limit+index]; }
+        ) const
+        {
+            checking::check_history_index(this, index, history_size);
+            return history_at(index);
+        }
 
 
         inline void shift_buffers (
             unsigned long N
-        ) { shift_buffer(N); }
+        )
+        {
+            checking::check_shift(this, N, lookahead_size);
+            tracer.on_shift(N);
+            shift_buffer(N);
+        }
+
+        inline tracing& get_tracer (
+        ) { return tracer; }
+
+        inline const tracing& get_tracer (
+        ) const { return tracer; }
+
+        void copy_state_from (
+            const lz77_buffer_kernel_2<sliding_buffer,checking,stats,tracing,allocator>& item
+        );
+        /*!
+            requires
+                - item.get_history_buffer_limit() == get_history_buffer_limit()
+                - item.get_lookahead_buffer_limit() == get_lookahead_buffer_limit()
+            ensures
+                - #*this is in the same state as item: same history and lookahead
+                  buffers and the same hash chains.  This costs a copy of the
+                  tables rather than hashing every symbol through add() again.
+        !*/
 
     private:
 
+        // unchecked accessors for the kernel's own use
+        inline unsigned char lookahead_at (
+            unsigned long index
+        ) const { return buffer[lookahead_limit-1-index]; }
+
+        inline unsigned char history_at (
+            unsigned long index
+        ) const { return buffer[lookahead_limit+index]; }
+
         inline unsigned long hash (
             unsigned char a,
             unsigned char b,
@@ -87,6 +135,28 @@ namespace dlib{
         void shift_buffer (
             unsigned long N
         );   
+
+        // node and node* are trivial, so the tables need no construction
+        template <typename T>
+        T* allocate_table (
+            unsigned long n
+        )
+        {
+            typename std::allocator_traits<allocator>::template rebind_alloc<T> a(alloc);
+            return std::allocator_traits<decltype(a)>::allocate(a, n);
+        }
+
+        template <typename T>
+        void deallocate_table (
+            T* table,
+            unsigned long n
+        )
+        {
+            typename std::allocator_traits<allocator>::template rebind_alloc<T> a(alloc);
+            std::allocator_traits<decltype(a)>::deallocate(a, table, n);
+        }
+
+        [[no_unique_address]] allocator alloc;
         sliding_buffer buffer;
         unsigned long lookahead_limit;
         unsigned long history_limit;
@@ -106,10 +176,12 @@ namespace dlib{
         unsigned long lookahead_size;
         unsigned long history_size;
 
+        [[no_unique_address]] tracing tracer;
+
 
         // restricted functions
-        lz77_buffer_kernel_2(lz77_buffer_kernel_2<sliding_buffer>&);        // copy constructor
-        lz77_buffer_kernel_2<sliding_buffer>& operator=(lz77_buffer_kernel_2<sliding_buffer>&);    // assignment operator
+        lz77_buffer_kernel_2(lz77_buffer_kernel_2<sliding_buffer,checking,stats,tracing,allocator>&);        // copy constructor
+        lz77_buffer_kernel_2<sliding_buffer,checking,stats,tracing,allocator>& operator=(lz77_buffer_kernel_2<sliding_buffer,checking,stats,tracing,allocator>&);    // assignment operator
     };   
 
 // ----------------------------------------------------------------------------------------
@@ -119,27 +191,35 @@ namespace dlib{
 // ----------------------------------------------------------------------------------------
     
     template <
-        typename sliding_buffer
+        typename sliding_buffer,
+        typename checking,
+        typename stats,
+        typename tracing,
+        typename allocator
         >
-    lz77_buffer_kernel_2<sliding_buffer>::
+    lz77_buffer_kernel_2<sliding_buffer,checking,stats,tracing,allocator>::
     lz77_buffer_kernel_2 (
         unsigned long total_limit_,
-        unsigned long lookahead_limit_  
+        unsigned long lookahead_limit_,
+        const allocator& alloc_
     ) :        
+        alloc(alloc_),
+        buffer(lz77_make_sliding_buffer<sliding_buffer>(alloc_)),
         lookahead_size(0),       
         history_size(0)
     {
+        checking::check_limits(total_limit_, lookahead_limit_);
         buffer.set_size(total_limit_);
         lookahead_limit = lookahead_limit_;
         history_limit = buffer.size() - lookahead_limit_;
 
-        nodes = new node[history_limit-3];
+        nodes = allocate_table<node>(history_limit-3);
 
-        try { id_table = new node*[buffer.size()]; }
-        catch (...) { delete [] nodes; throw; }
+        try { id_table = allocate_table<node*>(buffer.size()); }
+        catch (...) { deallocate_table(nodes, history_limit-3); throw; }
 
-        try { hash_table = new node*[buffer.size()]; }
-        catch (...) { delete [] id_table; delete [] nodes; throw; }
+        try { hash_table = allocate_table<node*>(buffer.size()); }
+        catch (...) { deallocate_table(id_table, buffer.size()); deallocate_table(nodes, history_limit-3); throw; }
 
         mask = buffer.size()-1;
         next_free_node = 0;
@@ -153,6 +233,10 @@ namespace dlib{
             ++start;
         }
 
+        // copy_state_from() reads every entry of id_table
+        for (unsigned long i = 0; i < buffer.size(); ++i)
+            id_table[i] = 0;
+
         for (unsigned long i = 0; i < buffer.size(); ++i)
             buffer[i] = 0;
 
@@ -161,23 +245,31 @@ namespace dlib{
 // ----------------------------------------------------------------------------------------
 
     template <
-        typename sliding_buffer
+        typename sliding_buffer,
+        typename checking,
+        typename stats,
+        typename tracing,
+        typename allocator
         >
-    lz77_buffer_kernel_2<sliding_buffer>::
+    lz77_buffer_kernel_2<sliding_buffer,checking,stats,tracing,allocator>::
     ~lz77_buffer_kernel_2 (
     )      
     {
-        delete [] nodes;
-        delete [] hash_table;
-        delete [] id_table;
+        deallocate_table(nodes, history_limit-3);
+        deallocate_table(hash_table, buffer.size());
+        deallocate_table(id_table, buffer.size());
     }
 
 // ----------------------------------------------------------------------------------------
     
     template <
-        typename sliding_buffer
+        typename sliding_buffer,
+        typename checking,
+        typename stats,
+        typename tracing,
+        typename allocator
         >
-    void lz77_buffer_kernel_2<sliding_buffer>::
+    void lz77_buffer_kernel_2<sliding_buffer,checking,stats,tracing,allocator>::
     clear(
     )
     {
@@ -194,12 +286,56 @@ namespace dlib{
         }
     }
 
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename sliding_buffer,
+        typename checking,
+        typename stats,
+        typename tracing,
+        typename allocator
+        >
+    void lz77_buffer_kernel_2<sliding_buffer,checking,stats,tracing,allocator>::
+    copy_state_from (
+        const lz77_buffer_kernel_2<sliding_buffer,checking,stats,tracing,allocator>& item
+    )
+    {
+        DLIB_CASSERT(item.history_limit == history_limit && item.lookahead_limit == lookahead_limit,
+            "\tvoid lz77_buffer_kernel_2::copy_state_from()"
+            << "\n\tboth buffers must have the same limits"
+            << "\n\tthis: " << this
+            );
+
+        buffer = item.buffer;
+        lookahead_size = item.lookahead_size;
+        history_size = item.history_size;
+        next_free_node = item.next_free_node;
+
+        // the hash chains point into item.nodes, so rebase them onto our nodes
+        const node* const base = item.nodes;
+        for (unsigned long i = 0; i < next_free_node; ++i)
+        {
+            nodes[i].id = base[i].id;
+            nodes[i].next = base[i].next ? nodes + (base[i].next - base) : 0;
+        }
+
+        for (unsigned long i = 0; i < buffer.size(); ++i)
+        {
+            hash_table[i] = item.hash_table[i] ? nodes + (item.hash_table[i] - base) : 0;
+            id_table[i] = item.id_table[i] ? nodes + (item.id_table[i] - base) : 0;
+        }
+    }
+
 // ----------------------------------------------------------------------------------------
       
     template <
-        typename sliding_buffer
+        typename sliding_buffer,
+        typename checking,
+        typename stats,
+        typename tracing,
+        typename allocator
         >      
-    void lz77_buffer_kernel_2<sliding_buffer>::
+    void lz77_buffer_kernel_2<sliding_buffer,checking,stats,tracing,allocator>::
     shift_buffer (
         unsigned long N
     )        
@@ -242,7 +378,11 @@ namespace dlib{
         }
 
         unsigned long i = lookahead_limit + 2;
-    
+        // with less than 3 symbols of history the elements just above the
+        // lookahead buffer are not history yet, so the first new node is lower
+        if (old_history_size < 3)
+            i -= 3 - old_history_size;
+
         // if there are any "new" nodes to add to the hash table 
         if (new_nodes != 0)
         {
@@ -323,13 +463,18 @@ namespace dlib{
 // ----------------------------------------------------------------------------------------
 
     template <
-        typename sliding_buffer
+        typename sliding_buffer,
+        typename checking,
+        typename stats,
+        typename tracing,
+        typename allocator
         >
-    void lz77_buffer_kernel_2<sliding_buffer>::
+    void lz77_buffer_kernel_2<sliding_buffer,checking,stats,tracing,allocator>::
     add (
         unsigned char symbol
     )
     {
+        tracer.on_add(symbol);
         if (lookahead_size == lookahead_limit)
         {
             shift_buffer(1);            
@@ -341,9 +486,13 @@ namespace dlib{
 // ----------------------------------------------------------------------------------------
     
     template <
-        typename sliding_buffer
+        typename sliding_buffer,
+        typename checking,
+        typename stats,
+        typename tracing,
+        typename allocator
         >
-    void lz77_buffer_kernel_2<sliding_buffer>::
+    void lz77_buffer_kernel_2<sliding_buffer,checking,stats,tracing,allocator>::
     find_match (
         unsigned long& index,
         unsigned long& length,
@@ -352,12 +501,13 @@ namespace dlib{
     {
         unsigned long match_length = 0;   // the length of the longest match we find
         unsigned long match_index = 0;    // the index of the longest match we find
+        unsigned long chain_length = 0;   // hash chain nodes visited, for the stats policy
 
  
-        const unsigned long hash_value = hash(lookahead_buffer(0),
-                                              lookahead_buffer(1),
-                                              lookahead_buffer(2),
-                                              lookahead_buffer(3)
+        const unsigned long hash_value = hash(lookahead_at(0),
+                                              lookahead_at(1),
+                                              lookahead_at(2),
+                                              lookahead_at(3)
                                               );
 
 
@@ -365,13 +515,14 @@ namespace dlib{
         node* temp = hash_table[hash_value];
         while (temp != 0)
         {             
+            ++chain_length;
             // current position in the history buffer
-            unsigned long hpos = temp->id-lookahead_limit;  
+            unsigned long hpos = buffer.get_element_index(temp->id)-lookahead_limit;  
             // current position in the lookahead buffer
             unsigned long lpos = 0;             
 
             // find length of this match
-            while (history_buffer(hpos) == lookahead_buffer(lpos))
+            while (history_at(hpos) == lookahead_at(lpos))
             {
                 ++lpos;
                 if (hpos == 0)
@@ -384,7 +535,7 @@ namespace dlib{
             if (lpos > match_length)
             {
                 match_length = lpos;
-                match_index = temp->id-lookahead_limit;
+                match_index = buffer.get_element_index(temp->id)-lookahead_limit;
                 // if this is the longest possible match then stop looking
                 if (lpos == lookahead_limit)
                     break;
@@ -408,6 +559,8 @@ namespace dlib{
         {
             length = 0;
         }
+        stats::find_match(chain_length, length);
+        tracer.on_find_match(length != 0 ? index : 0, length);
     }
 
 // ----------------------------------------------------------------------------------------
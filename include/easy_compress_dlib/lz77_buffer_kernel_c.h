@@ -2,9 +2,8 @@
 #define DLIB_LZ77_BUFFER_KERNEl_C_
 
 #include "lz77_buffer_kernel_abstract.h"
+#include "lz77_buffer_policies.h"
 #include "../algs.h"
-#include "../assert.h"
-#include <iostream>
 
 namespace dlib
 {
@@ -12,156 +11,38 @@ namespace dlib
     template <
         typename lz77_base
         >
-    class lz77_buffer_kernel_c : public lz77_base
-    {
-        
-        public:
-        lz77_buffer_kernel_c (
-            unsigned long total_limit,
-            unsigned long lookahead_limit            
-        );
-
-        unsigned char lookahead_buffer (
-            unsigned long index
-        ) const;
-
-        unsigned char history_buffer (
-            unsigned long index
-        ) const;
-
-        void shift_buffers (
-            unsigned long N
-        );
-
-
-
-        unsigned long make_safe (
-            unsigned long total_limit,
-            unsigned long lookahead_limit
-        )
-        /*!
-            ensures
-                - if ( 6 < total_limit < 32 && 
-                       15 < lookahead_limit <= 2^(total_limit-2) 
-                       ) then
-                    - returns total_limit
-                - else
-                    - throws due to failed CASSERT
-        !*/
-        {
-            unsigned long exp_size = (total_limit!=0)?total_limit-2:0;
-            unsigned long two_pow_total_limit_minus_2 = 1;
-            while (exp_size != 0)
-            {
-                --exp_size;
-                two_pow_total_limit_minus_2 <<= 1;            
-            }
-
-            // make sure requires clause is not broken
-            DLIB_CASSERT( 6 < total_limit && total_limit < 32 &&
-                    15 < lookahead_limit && lookahead_limit <= two_pow_total_limit_minus_2,
-                "\tlz77_buffer::lz77_buffer(unsigned long,unsigned long)"
-                << "\n\ttotal_limit must be in the range 7 to 31 and \n\tlookahead_limit in the range 15 to 2^(total_limit-2)"
-                << "\n\tthis:            " << this
-                << "\n\ttotal_limit:     " << total_limit
-                << "\n\tlookahead_limit: " << lookahead_limit
-                );
-
-            return total_limit;
-        }
-
-    };
-
-// ----------------------------------------------------------------------------------------
-// ----------------------------------------------------------------------------------------
-    // member function definitions
-// ----------------------------------------------------------------------------------------
-// ----------------------------------------------------------------------------------------
+    struct lz77_buffer_with_checks;
+    /*!
+        requires
+            - lz77_base is an lz77_buffer kernel taking policy arguments
+              (sliding_buffer, checking, stats, tracing, allocator)
+        ensures
+            - type is lz77_base with its checking policy replaced by
+              lz77_full_checks, keeping its stats and tracing policies and
+              its allocator
+    !*/
 
     template <
-        typename lz77_base
+        template <typename, typename, typename, typename, typename> class kernel,
+        typename sliding_buffer,
+        typename checking,
+        typename stats,
+        typename tracing,
+        typename allocator
         >
-    void lz77_buffer_kernel_c<lz77_base>::
-    shift_buffers (
-            unsigned long N
-    ) 
+    struct lz77_buffer_with_checks<kernel<sliding_buffer,checking,stats,tracing,allocator> >
     {
-        // make sure requires clause is not broken
-        DLIB_CASSERT( N <= this->get_lookahead_buffer_size(),
-            "\tvoid lz77_buffer::shift_buffers(unsigned long)"
-            << "\n\tN must be <= the number of chars in the lookahead buffer"
-            << "\n\tthis:                        " << this
-            << "\n\tget_lookahead_buffer_size(): " << this->get_lookahead_buffer_size()
-            << "\n\tN:                           " << N
-            );
-
-        // call the real function
-        lz77_base::shift_buffers(N);
-    }
-
-// ----------------------------------------------------------------------------------------
-
-    template <
-        typename lz77_base
-        >
-    unsigned char lz77_buffer_kernel_c<lz77_base>::
-    history_buffer (
-            unsigned long index
-    ) const
-    {
-        // make sure requires clause is not broken
-        DLIB_CASSERT( index < this->get_history_buffer_size(),
-            "\tunsigned char lz77_buffer::history_buffer(unsigned long) const"
-            << "\n\tindex must be in the range 0 to get_history_buffer_size()-1"
-            << "\n\tthis:                      " << this
-            << "\n\tget_history_buffer_size(): " << this->get_history_buffer_size()
-            << "\n\tindex:                     " << index
-            );
-
-        // call the real function
-        return lz77_base::history_buffer(index);
-    }
-
-// ----------------------------------------------------------------------------------------
-
-    template <
-        typename lz77_base
-        >
-    unsigned char lz77_buffer_kernel_c<lz77_base>::
-    lookahead_buffer (
-            unsigned long index
-    ) const
-    {
-        // make sure requires clause is not broken
-        DLIB_CASSERT( index < this->get_lookahead_buffer_size(),
-            "\tunsigned char lz77_buffer::lookahead_buffer(unsigned long) const"
-            << "\n\tindex must be in the range 0 to get_lookahead_buffer_size()-1"
-            << "\n\tthis:                        " << this
-            << "\n\tget_lookahead_buffer_size(): " << this->get_lookahead_buffer_size()
-            << "\n\tindex:                       " << index
-            );
-
-        // call the real function
-        return lz77_base::lookahead_buffer(index);
-    }
-
-// ----------------------------------------------------------------------------------------
+        typedef kernel<sliding_buffer,lz77_full_checks,stats,tracing,allocator> type;
+    };
 
+    // The checked version of a kernel, which used to be a wrapper class.  It
+    // is the kernel itself with full checks, so lz77_buffer_kernel_c<K> and
+    // K<..., lz77_full_checks, ...> are the same type.
     template <
         typename lz77_base
         >
-    lz77_buffer_kernel_c<lz77_base>::
-    lz77_buffer_kernel_c (
-        unsigned long total_limit,
-        unsigned long lookahead_limit  
-    ) :
-        lz77_base(make_safe(total_limit,lookahead_limit),lookahead_limit)
-    {
-    }
-
-// ----------------------------------------------------------------------------------------
+    using lz77_buffer_kernel_c = typename lz77_buffer_with_checks<lz77_base>::type;
 
 }
 
 #endif // DLIB_LZ77_BUFFER_KERNEl_C_
-
@@ -0,0 +1,174 @@
+#ifndef DLIB_LZ77_BUFFER_POLICIES_
+#define DLIB_LZ77_BUFFER_POLICIES_
+
+#include "../algs.h"
+#include "../assert.h"
+#include "metrics.h"
+#include <memory>
+#include <type_traits>
+
+namespace dlib
+{
+
+    /*!
+        Policies for lz77_buffer_kernel_1 and lz77_buffer_kernel_2.
+
+        Every kernel takes three policy arguments after the sliding_buffer:
+
+            checking - validates the requires clauses of the public interface
+                       (lz77_buffer_kernel_abstract.h).  Its static functions
+                       are called with the arguments and the relevant size on
+                       every constructor, lookahead_buffer(), history_buffer()
+                       and shift_buffers() call.
+            stats    - static find_match(candidates, match_length), called once
+                       per find_match() with the number of candidate positions
+                       examined (hash chain nodes for kernel_2) and the length
+                       of the match reported, 0 for none.
+            tracing  - an object held by the kernel and reachable through
+                       get_tracer(), so it may keep state.  on_add(symbol),
+                       on_shift(N) and on_find_match(index, length) are
+                       called on the matching public calls; index is 0 when
+                       no match was found.
+
+        The "no" policies are empty inline functions, so a kernel built with
+        them is the same code as one without hooks.  Internal buffer accesses
+        never go through the checks, which only guard the caller's side of the
+        contract.
+
+        A last argument, allocator, is a standard allocator (std::allocator<char>
+        by default) passed to the constructor.  kernel_2 rebinds it for its node
+        and hash tables, and both kernels hand it to the sliding_buffer when it
+        can be constructed from one (see basic_sliding_buffer), so a kernel can
+        take all of its memory from one arena.
+    !*/
+
+    template <
+        typename sliding_buffer,
+        typename allocator
+        >
+    sliding_buffer lz77_make_sliding_buffer (
+        const allocator& alloc
+    )
+    /*!
+        ensures
+            - returns sliding_buffer(alloc) if sliding_buffer has that
+              constructor, or else sliding_buffer()
+    !*/
+    {
+        if constexpr (std::is_constructible_v<sliding_buffer, const allocator&>)
+            return sliding_buffer(alloc);
+        else
+            return sliding_buffer();
+    }
+
+// ----------------------------------------------------------------------------------------
+    // checking policies
+// ----------------------------------------------------------------------------------------
+
+    struct lz77_no_checks
+    {
+        static void check_limits (unsigned long, unsigned long) {}
+        static void check_lookahead_index (const void*, unsigned long, unsigned long) {}
+        static void check_history_index (const void*, unsigned long, unsigned long) {}
+        static void check_shift (const void*, unsigned long, unsigned long) {}
+    };
+
+    struct lz77_full_checks
+    {
+        static void check_limits (
+            unsigned long total_limit,
+            unsigned long lookahead_limit
+        )
+        {
+            // the largest lookahead_limit is 2^(total_limit-2); only shift
+            // once the total_limit is known to be in range
+            DLIB_CASSERT( 6 < total_limit && total_limit < 32 &&
+                    15 < lookahead_limit && lookahead_limit <= (1ul << (total_limit-2)),
+                "\tlz77_buffer::lz77_buffer(unsigned long,unsigned long)"
+                << "\n\ttotal_limit must be in the range 7 to 31 and \n\tlookahead_limit in the range 15 to 2^(total_limit-2)"
+                << "\n\ttotal_limit:     " << total_limit
+                << "\n\tlookahead_limit: " << lookahead_limit
+                );
+        }
+
+        static void check_lookahead_index (
+            const void* kernel,
+            unsigned long index,
+            unsigned long lookahead_size
+        )
+        {
+            DLIB_CASSERT( index < lookahead_size,
+                "\tunsigned char lz77_buffer::lookahead_buffer(unsigned long) const"
+                << "\n\tindex must be in the range 0 to get_lookahead_buffer_size()-1"
+                << "\n\tthis:                        " << kernel
+                << "\n\tget_lookahead_buffer_size(): " << lookahead_size
+                << "\n\tindex:                       " << index
+                );
+        }
+
+        static void check_history_index (
+            const void* kernel,
+            unsigned long index,
+            unsigned long history_size
+        )
+        {
+            DLIB_CASSERT( index < history_size,
+                "\tunsigned char lz77_buffer::history_buffer(unsigned long) const"
+                << "\n\tindex must be in the range 0 to get_history_buffer_size()-1"
+                << "\n\tthis:                      " << kernel
+                << "\n\tget_history_buffer_size(): " << history_size
+                << "\n\tindex:                     " << index
+                );
+        }
+
+        static void check_shift (
+            const void* kernel,
+            unsigned long N,
+            unsigned long lookahead_size
+        )
+        {
+            DLIB_CASSERT( N <= lookahead_size,
+                "\tvoid lz77_buffer::shift_buffers(unsigned long)"
+                << "\n\tN must be <= the number of chars in the lookahead buffer"
+                << "\n\tthis:                        " << kernel
+                << "\n\tget_lookahead_buffer_size(): " << lookahead_size
+                << "\n\tN:                           " << N
+                );
+        }
+    };
+
+// ----------------------------------------------------------------------------------------
+    // stats policies
+// ----------------------------------------------------------------------------------------
+
+    struct lz77_no_stats
+    {
+        static void find_match (unsigned long, unsigned long) {}
+    };
+
+    // Records into the library counters (metrics.h), which are themselves
+    // compiled out by EASY_COMPRESS_DLIB_DISABLE_METRICS
+    struct lz77_metrics_stats
+    {
+        static void find_match (
+            unsigned long candidates,
+            unsigned long match_length
+        ) { easy_compress_dlib::record_find_match(candidates, match_length); }
+    };
+
+// ----------------------------------------------------------------------------------------
+    // tracing policies
+// ----------------------------------------------------------------------------------------
+
+    struct lz77_no_tracing
+    {
+        void on_add (unsigned char) {}
+        void on_shift (unsigned long) {}
+        void on_find_match (unsigned long, unsigned long) {}
+    };
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_LZ77_BUFFER_POLICIES_
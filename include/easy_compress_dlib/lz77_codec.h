@@ -0,0 +1,187 @@
+#ifndef EASY_COMPRESS_DLIB_LZ77_CODEC_H
+#define EASY_COMPRESS_DLIB_LZ77_CODEC_H
+
+#include "allocators.h"
+#include "hw_profiler.h"
+#include "lz77_buffer_kernel_2.h"
+#include "sliding_buffer.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace easy_compress_dlib {
+
+// LZ77 token codec over dlib::lz77_buffer_kernel_2
+//
+// The payload is a sequence of tokens, each starting with a varint tag
+// (length << 2 | kind):
+//
+//   kind 0  literals: length raw bytes follow
+//   kind 1  match:    a varint distance follows; copy length bytes starting
+//                     distance bytes back in the output (may overlap itself)
+//   kind 2  run:      one byte follows, repeated length times
+//
+// Kind 3 is reserved. Varints are little endian base 128.
+//
+// Runs of lz77_min_run_length or more identical bytes are found up front by
+// the run detector and never go through find_match.
+
+using lz77_kernel = dlib::lz77_buffer_kernel_2<sliding_buffer>;
+// The same kernel with its buffer and tables in a MonotonicArena
+using lz77_arena_kernel =
+    dlib::lz77_buffer_kernel_2<basic_sliding_buffer<ArenaAllocator<unsigned char>>, dlib::lz77_no_checks,
+                               dlib::lz77_metrics_stats, dlib::lz77_no_tracing, ArenaAllocator<char>>;
+
+constexpr unsigned long lz77_total_limit = 16;        // log2 of the buffer size, a 64 KB window
+constexpr unsigned long lz77_lookahead_limit = 256;
+constexpr unsigned long lz77_min_match_length = 4;    // kernel_2 hashes 4 symbols
+
+constexpr std::size_t lz77_min_run_length = 32;
+// Runs at least this long reset the kernel rather than pass through its history
+constexpr std::size_t lz77_run_reset_length = 8 * 1024;
+
+// Most the encoder can look back, so also the most history priming can use
+constexpr std::size_t lz77_history_limit = (std::size_t(1) << lz77_total_limit) - lz77_lookahead_limit;
+
+// Window of an LZ77 encoder: total_limit is the log2 of the buffer size, and
+// kernel_2 sizes its hash table to the buffer. Tokens do not depend on it, so
+// any window decodes with lz77_decode and the primed decoder; a smaller one
+// just finds fewer matches. memory_budget.h picks one to fit a memory limit.
+struct Lz77Config {
+    unsigned long total_limit = lz77_total_limit;
+    unsigned long lookahead_limit = lz77_lookahead_limit;
+
+    bool operator==(const Lz77Config&) const = default;
+};
+
+constexpr unsigned long lz77_min_total_limit = 10;
+
+// Throws std::invalid_argument unless lz77_min_total_limit <= total_limit < 32
+// and lz77_min_match_length <= lookahead_limit <= 2^(total_limit-2)
+void check_lz77_config(const Lz77Config& config);
+
+enum class Lz77TokenKind : std::uint8_t { literals = 0, match = 1, run = 2 };
+
+inline void put_varint(std::string& out, std::uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+// Returns false on truncated or overlong input
+inline bool get_varint(std::string_view& in, std::uint64_t& value) {
+    value = 0;
+    for (unsigned shift = 0; shift < 64 && !in.empty(); shift += 7) {
+        const auto byte = static_cast<unsigned char>(in.front());
+        in.remove_prefix(1);
+        value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Append a single match token
+void put_lz77_match(std::string& output, std::uint64_t length, std::uint64_t distance);
+
+// Append a literals token, nothing for an empty view
+inline void put_lz77_literals(std::string& output, std::string_view literals) {
+    if (!literals.empty()) {
+        put_varint(output, (literals.size() << 2) | static_cast<std::uint64_t>(Lz77TokenKind::literals));
+        output.append(literals);
+    }
+}
+
+// Push history through the kernel as if it had just been encoded, so that later
+// matches can refer back into it. Only the last get_history_buffer_limit()
+// bytes are kept. The lookahead buffer must be empty.
+void lz77_prime(lz77_kernel& kernel, std::string_view history);
+void lz77_prime(lz77_arena_kernel& kernel, std::string_view history);
+
+// Encode input, appending tokens to output. Matches may reach back into
+// whatever the kernel already holds in its history buffer.
+void lz77_encode(lz77_kernel& kernel, std::string_view input, std::string& output);
+void lz77_encode(lz77_arena_kernel& kernel, std::string_view input, std::string& output);
+
+// The match loop of lz77_encode without the run detector, through any
+// lz77_buffer kernel: literals and matches only, appended to output. The
+// benchmark compares match finders with it.
+template <typename Kernel>
+void lz77_encode_segment(Kernel& kernel, std::string_view input, std::string& output) {
+    const unsigned long lookahead_limit = kernel.get_lookahead_buffer_limit();
+    std::size_t added = 0;           // input bytes added to the kernel
+    std::size_t encoded = 0;         // input bytes covered by tokens or pending literals
+    std::size_t literal_start = 0;
+
+    auto fill = [&] {
+        while (kernel.get_lookahead_buffer_size() < lookahead_limit && added < input.size()) {
+            kernel.add(static_cast<unsigned char>(input[added++]));
+        }
+    };
+
+    fill();
+    while (kernel.get_lookahead_buffer_size() != 0) {
+        unsigned long index = 0;
+        unsigned long length = 0;
+        if (kernel.get_lookahead_buffer_size() >= lz77_min_match_length) {
+            ProfileScope scope(profile_region(ProfileRegion::find_match), 1);
+            kernel.find_match(index, length, lz77_min_match_length);   // shifts past the match
+            if (length != 0) {
+                scope.set_bytes(length);
+            }
+        }
+        if (length != 0) {
+            put_lz77_literals(output, input.substr(literal_start, encoded - literal_start));
+            put_lz77_match(output, length, index + 1);
+            encoded += length;
+            literal_start = encoded;
+        } else {
+            ProfileScope scope(profile_region(ProfileRegion::shift_buffer), 1);
+            kernel.shift_buffers(1);
+            ++encoded;
+        }
+        fill();
+    }
+    put_lz77_literals(output, input.substr(literal_start, encoded - literal_start));
+}
+
+// No bound on the decoded size, for callers that do not know it
+constexpr std::size_t lz77_unbounded = static_cast<std::size_t>(-1);
+
+// Decode tokens, appending to output. Matches may reach back into bytes already
+// in output, which is how a primed history is decoded: start from it and strip
+// it afterwards. Throws std::runtime_error on malformed input, and on any
+// token that would append more than max_size bytes in all; a stream can ask
+// for gigabytes in a few bytes, so pass the expected size whenever it is known.
+void lz77_decode(std::string_view tokens, std::string& output, std::size_t max_size = lz77_unbounded);
+
+// kernel_function wrapper with an empty history (lz77_kernel_index)
+void compress_lz77(const std::string& input, std::string& output);
+// The inverse, with the output limited to max_size bytes; timed as a
+// lz77_kernel_index call
+void decompress_lz77(std::string_view input, std::string& output, std::size_t max_size);
+
+// compress_lz77 with the kernel built in arena, which then holds all of the
+// call's state apart from output; the caller releases the arena when done
+void compress_lz77(std::string_view input, std::string& output, MonotonicArena& arena);
+
+// Compress input as if it directly followed history, so matches can reach back
+// into it. Only the last lz77_history_limit bytes of history are used; the
+// decompressor must be given the same history.
+void compress_lz77_primed(std::string_view history, std::string_view input, std::string& output);
+// Both with another window; they bypass compress_with_kernel and are timed
+// and profiled as lz77_kernel_index calls themselves
+void compress_lz77(std::string_view input, std::string& output, const Lz77Config& config);
+void compress_lz77_primed(std::string_view history, std::string_view input, std::string& output,
+                          const Lz77Config& config);
+// max_size bounds the output, without the history
+void decompress_lz77_primed(std::string_view history, std::string_view input, std::string& output,
+                            std::size_t max_size);
+
+} // namespace easy_compress_dlib
+
+#endif // EASY_COMPRESS_DLIB_LZ77_CODEC_H
@@ -0,0 +1,105 @@
+#ifndef EASY_COMPRESS_DLIB_MEMORY_BUDGET_H
+#define EASY_COMPRESS_DLIB_MEMORY_BUDGET_H
+
+#include "lz77_codec.h"
+#include "metrics.h"
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <string>
+
+namespace easy_compress_dlib {
+
+// Memory budgets
+//
+// Every codec call needs its model or window plus the input and output of the
+// block. For LZ77 the kernel is computed exactly: lz77_buffer_kernel_2 keeps
+// the window, a node per history position and a hash and an id table of one
+// pointer per window byte, about 33 bytes per window byte. The dlib
+// compress_stream kernels allocate their models internally; their figures are
+// rough defaults until calibrate_kernel_memory measures them or
+// set_kernel_model_memory replaces them.
+//
+// A memory_limit option (AdaptiveOptions, ArchiveOptions) shrinks the LZ77
+// window so one call per thread fits, and makes every block task reserve its
+// expected memory from a MemoryBudget, so no more tasks run at once than the
+// limit holds.
+
+// Bytes an lz77_buffer_kernel_2 with this window allocates
+std::size_t lz77_kernel_memory(const Lz77Config& config);
+
+// The largest window, no larger than the default, whose kernel fits in bytes;
+// the smallest window if none does
+Lz77Config lz77_config_for_memory(std::size_t bytes);
+
+// Memory a codec holds for one call besides its input and output: the LZ77
+// kernel when compressing with config, nothing when decoding LZ77, the model
+// for the others. Throws std::out_of_range for an invalid codec index.
+std::size_t kernel_model_memory(int codec_index, KernelOperation operation, const Lz77Config& config = {});
+
+// Expected peak of one compress or decompress call on a block of raw_size
+// bytes: the model, a copy of the input and the output
+std::size_t kernel_call_memory(int codec_index, KernelOperation operation, std::size_t raw_size,
+                               const Lz77Config& config = {});
+
+// Replace the model figure of a dlib kernel (codec indices 1 to kernel_count)
+void set_kernel_model_memory(int codec_index, KernelOperation operation, std::size_t bytes);
+
+// With allocation tracking built in (allocation_tracking.h), compress and
+// decompress sample with a dlib kernel and store the bytes allocated beyond
+// the input and output as its model figures. Returns false, changing nothing,
+// without allocation tracking.
+bool calibrate_kernel_memory(int codec_index, const std::string& sample);
+
+// Table of the model and per-call figures of every codec for blocks of
+// raw_size bytes
+std::string memory_report(std::size_t raw_size, const Lz77Config& config = {});
+
+// Memory shared by concurrent tasks
+//
+// acquire(bytes) blocks until bytes fit next to the other reservations. A
+// request above the limit is cut down to it, so it waits until nothing else is
+// reserved and then runs alone. A limit of 0 means no limit.
+class MemoryBudget {
+public:
+    explicit MemoryBudget(std::size_t limit) : limit_(limit) {}
+
+    MemoryBudget(const MemoryBudget&) = delete;
+    MemoryBudget& operator=(const MemoryBudget&) = delete;
+
+    // Returns the bytes actually reserved, to be passed to release
+    std::size_t acquire(std::size_t bytes);
+    void release(std::size_t reserved);
+
+    std::size_t limit() const { return limit_; }
+    std::size_t in_use() const;
+
+private:
+    const std::size_t limit_;
+    mutable std::mutex mutex_;
+    std::condition_variable freed_;
+    std::size_t in_use_ = 0;
+};
+
+class MemoryReservation {
+public:
+    MemoryReservation(MemoryBudget& budget, std::size_t bytes)
+        : budget_(budget), reserved_(budget.acquire(bytes)) {}
+    ~MemoryReservation() { budget_.release(reserved_); }
+
+    MemoryReservation(const MemoryReservation&) = delete;
+    MemoryReservation& operator=(const MemoryReservation&) = delete;
+
+private:
+    MemoryBudget& budget_;
+    std::size_t reserved_;
+};
+
+// The window to use with memory_limit bytes shared by threads (0 = hardware
+// concurrency): one LZ77 call per thread on blocks of block_size must fit.
+// The default window when memory_limit is 0.
+Lz77Config lz77_config_for_budget(std::size_t memory_limit, unsigned threads, std::size_t block_size);
+
+} // namespace easy_compress_dlib
+
+#endif // EASY_COMPRESS_DLIB_MEMORY_BUDGET_H
@@ -0,0 +1,236 @@
+#ifndef EASY_COMPRESS_DLIB_METRICS_H
+#define EASY_COMPRESS_DLIB_METRICS_H
+
+#include "allocation_tracking.h"
+#include "kernel_table.h"
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace easy_compress_dlib {
+
+// Built-in performance counters
+//
+// Every thread records into its own block of counters, so recording is a
+// relaxed load and store with no contention; collect_metrics sums the blocks
+// of live threads and of threads that have exited. Recorded per codec and
+// operation: calls, errors, bytes in and out, a latency histogram, and in the
+// allocation audit mode (allocation_tracking.h) the heap allocations. Also
+// recorded: the kernels select_kernel picks, and through the lz77_buffer
+// kernels' default stats policy (lz77_buffer_policies.h) the find_match calls,
+// matches found, matched bytes and candidate positions examined.
+//
+// Histograms have log2 buckets: bucket 0 holds zero, bucket b values in
+// [2^(b-1), 2^b), and the last bucket everything above. Latencies are in
+// nanoseconds.
+//
+// Building with EASY_COMPRESS_DLIB_DISABLE_METRICS removes the recording
+// entirely; collect_metrics then always returns zeros.
+
+#ifdef EASY_COMPRESS_DLIB_DISABLE_METRICS
+constexpr bool metrics_enabled = false;
+#else
+constexpr bool metrics_enabled = true;
+#endif
+
+constexpr std::size_t histogram_buckets = 40;
+
+enum class KernelOperation { compress = 0, decompress = 1 };
+constexpr std::size_t kernel_operation_count = 2;
+
+const char* kernel_operation_name(KernelOperation operation);
+
+struct HistogramSnapshot {
+    std::array<std::uint64_t, histogram_buckets> buckets{};
+    std::uint64_t sum = 0;
+
+    std::uint64_t count() const;
+    // Exclusive upper bound of a bucket; the last bucket has none and returns 0
+    static std::uint64_t bucket_limit(std::size_t bucket);
+    // Upper bound of the bucket holding the p-th percentile (p in [0, 100]), 0 if empty
+    std::uint64_t percentile(double p) const;
+};
+
+struct KernelCallSnapshot {
+    std::uint64_t calls = 0;
+    std::uint64_t errors = 0;    // calls that threw
+    std::uint64_t bytes_in = 0;
+    std::uint64_t bytes_out = 0;
+    std::uint64_t allocations = 0;       // 0 unless allocation tracking is built in
+    std::uint64_t allocated_bytes = 0;
+    HistogramSnapshot latency_ns;
+};
+
+struct MetricsSnapshot {
+    // [codec_index - 1][operation]
+    std::array<std::array<KernelCallSnapshot, kernel_operation_count>, codec_count> kernels{};
+    // Results of select_kernel, [kernel_index - 1]
+    std::array<std::uint64_t, codec_count> selections{};
+    std::uint64_t find_match_calls = 0;
+    std::uint64_t find_match_matches = 0;
+    std::uint64_t matched_bytes = 0;
+    HistogramSnapshot chain_length;   // candidates per find_match call, hash chain nodes for kernel_2
+
+    const KernelCallSnapshot& kernel(int codec_index, KernelOperation operation) const;
+};
+
+// Everything recorded since startup or the last reset_metrics
+MetricsSnapshot collect_metrics();
+// Later snapshots count from now on
+void reset_metrics();
+
+// Prometheus text exposition format, metric names prefixed with easy_compress_
+std::string metrics_prometheus(const MetricsSnapshot& snapshot);
+// {"schema": "easy_compress_dlib.metrics.v1", "kernels": [...], "selections": {...}, "lz77": {...}}
+std::string metrics_json(const MetricsSnapshot& snapshot);
+
+namespace metrics_detail {
+
+// Only the owning thread writes, so no read-modify-write is needed; the
+// atomics only make concurrent reads by collect_metrics well defined
+struct Counter {
+    std::atomic<std::uint64_t> value{0};
+
+    void add(std::uint64_t n) {
+        value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+    std::uint64_t get() const { return value.load(std::memory_order_relaxed); }
+};
+
+inline std::size_t histogram_bucket(std::uint64_t value) {
+    const std::size_t bucket = static_cast<std::size_t>(std::bit_width(value));
+    return bucket < histogram_buckets ? bucket : histogram_buckets - 1;
+}
+
+struct Histogram {
+    std::array<Counter, histogram_buckets> buckets;
+    Counter sum;
+
+    void record(std::uint64_t value) {
+        buckets[histogram_bucket(value)].add(1);
+        sum.add(value);
+    }
+};
+
+struct KernelCounters {
+    Counter calls;
+    Counter errors;
+    Counter bytes_in;
+    Counter bytes_out;
+    Counter allocations;
+    Counter allocated_bytes;
+    Histogram latency_ns;
+};
+
+struct alignas(64) ThreadMetrics {
+    std::array<std::array<KernelCounters, kernel_operation_count>, codec_count> kernels;
+    std::array<Counter, codec_count> selections;
+    Counter find_match_calls;
+    Counter find_match_matches;
+    Counter matched_bytes;
+    Histogram chain_length;
+};
+
+inline thread_local ThreadMetrics* current_thread = nullptr;
+
+// Allocates and registers the calling thread's counters
+ThreadMetrics& register_thread();
+
+inline ThreadMetrics& local() {
+    return current_thread ? *current_thread : register_thread();
+}
+
+inline KernelCounters* kernel_counters(int codec_index, KernelOperation operation) {
+    if (!is_valid_codec_index(codec_index)) {
+        return nullptr;
+    }
+    return &local().kernels[codec_index - 1][static_cast<std::size_t>(operation)];
+}
+
+} // namespace metrics_detail
+
+inline void record_kernel_selection([[maybe_unused]] int kernel_index) {
+    if constexpr (metrics_enabled) {
+        if (is_valid_codec_index(kernel_index)) {
+            metrics_detail::local().selections[kernel_index - 1].add(1);
+        }
+    }
+}
+
+inline void record_find_match([[maybe_unused]] unsigned long chain_length,
+                              [[maybe_unused]] unsigned long match_length) {
+    if constexpr (metrics_enabled) {
+        metrics_detail::ThreadMetrics& local = metrics_detail::local();
+        local.find_match_calls.add(1);
+        local.chain_length.record(chain_length);
+        if (match_length != 0) {
+            local.find_match_matches.add(1);
+            local.matched_bytes.add(match_length);
+        }
+    }
+}
+
+// Times one kernel call. Call done() with the output size once the kernel
+// returns; if it is never called, as when the kernel throws, the call counts
+// as an error.
+class KernelCallTimer {
+public:
+    KernelCallTimer([[maybe_unused]] int codec_index, [[maybe_unused]] KernelOperation operation,
+                    [[maybe_unused]] std::size_t bytes_in) {
+        if constexpr (metrics_enabled) {
+            counters_ = metrics_detail::kernel_counters(codec_index, operation);
+            bytes_in_ = bytes_in;
+            allocations_ = thread_allocation_stats();
+            start_ = std::chrono::steady_clock::now();
+        }
+    }
+
+    KernelCallTimer(const KernelCallTimer&) = delete;
+    KernelCallTimer& operator=(const KernelCallTimer&) = delete;
+
+    ~KernelCallTimer() {
+        if constexpr (metrics_enabled) {
+            if (counters_ && !done_) {
+                counters_->calls.add(1);
+                counters_->errors.add(1);
+                record_allocations();
+            }
+        }
+    }
+
+    void done([[maybe_unused]] std::size_t bytes_out) {
+        if constexpr (metrics_enabled) {
+            if (counters_) {
+                const auto elapsed = std::chrono::steady_clock::now() - start_;
+                counters_->calls.add(1);
+                counters_->bytes_in.add(bytes_in_);
+                counters_->bytes_out.add(bytes_out);
+                counters_->latency_ns.record(static_cast<std::uint64_t>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+                record_allocations();
+                done_ = true;
+            }
+        }
+    }
+
+private:
+    void record_allocations() {
+        const AllocationStats allocations = thread_allocation_stats() - allocations_;
+        counters_->allocations.add(allocations.allocations);
+        counters_->allocated_bytes.add(allocations.bytes);
+    }
+
+    metrics_detail::KernelCounters* counters_ = nullptr;
+    std::size_t bytes_in_ = 0;
+    AllocationStats allocations_;
+    std::chrono::steady_clock::time_point start_;
+    bool done_ = false;
+};
+
+} // namespace easy_compress_dlib
+
+#endif // EASY_COMPRESS_DLIB_METRICS_H
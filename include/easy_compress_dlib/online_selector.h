@@ -0,0 +1,94 @@
+#ifndef EASY_COMPRESS_DLIB_ONLINE_SELECTOR_H
+#define EASY_COMPRESS_DLIB_ONLINE_SELECTOR_H
+
+#include "kernel_selection.h"
+#include "kernel_table.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace easy_compress_dlib {
+
+// Running totals for one (file type, kernel) pair
+struct KernelObservation {
+    std::atomic<std::uint64_t> samples{0};
+    std::atomic<std::uint64_t> original_bytes{0};
+    std::atomic<std::uint64_t> compressed_bytes{0};
+    std::atomic<std::uint64_t> nanoseconds{0};
+};
+
+struct OnlineSelectorOptions {
+    double exploration_rate = 0.05;                 // epsilon for epsilon-greedy exploration
+    double prior_weight_bytes = 1 << 20;            // how many bytes the built-in metrics count for
+    std::string persist_path;                       // empty = never persist
+    std::chrono::seconds persist_interval{60};      // period of the background save, at least 1s
+};
+
+// Kernel selector that learns from real compressions. Every result is folded
+// into lock-free per-(file type, kernel) totals; estimates blend those totals
+// with the built-in metrics as a prior, and an epsilon-greedy policy keeps
+// exploring the other kernels.
+//
+// With a persist_path, a background thread saves the totals there every
+// persist_interval and once more on destruction; record() never touches the
+// file.
+class OnlineKernelSelector {
+public:
+    explicit OnlineKernelSelector(OnlineSelectorOptions options = {});
+    ~OnlineKernelSelector();
+
+    OnlineKernelSelector(const OnlineKernelSelector&) = delete;
+    OnlineKernelSelector& operator=(const OnlineKernelSelector&) = delete;
+
+    // Throws std::invalid_argument for an unknown file type
+    int select(const std::string& file_type, double alpha) const;
+
+    void record(const std::string& file_type, int kernel_index, std::size_t original_size,
+                std::size_t compressed_size, std::chrono::nanoseconds elapsed);
+    void record(const std::string& file_type, int kernel_index, const CompressionMetricEntry& entry,
+                std::chrono::nanoseconds elapsed);
+
+    // Select, compress, time and record; returns the kernel used
+    int compress(const std::string& file_type, double alpha, const std::string& input, std::string& output);
+
+    double estimated_bpb(const std::string& file_type, int kernel_index) const;
+    double estimated_throughput(const std::string& file_type, int kernel_index) const;   // bytes per second
+    std::uint64_t sample_count(const std::string& file_type, int kernel_index) const;
+
+    // CSV rows: file_type,kernel,samples,original_bytes,compressed_bytes,nanoseconds
+    void save(const std::string& filename) const;
+    void load(const std::string& filename);
+
+    // Save to options.persist_path now; does nothing without one. Throws
+    // std::runtime_error if the file cannot be written.
+    void persist();
+
+private:
+    struct Estimate {
+        double bpb;
+        double throughput;
+    };
+
+    const KernelObservation& observation(int type, int kernel_index) const;
+    KernelObservation& observation(int type, int kernel_index);
+    // type is a known_file_types index, kernel_index already validated
+    Estimate estimate(const KernelMetricsSet& metrics, int type, int kernel_index) const;
+    void persist_loop();
+
+    OnlineSelectorOptions options_;
+    std::array<std::array<KernelObservation, kernel_count>, known_file_types.size()> observations_;
+    std::mutex persist_mutex_;   // serializes saves to persist_path
+    std::condition_variable persist_wake_;
+    bool stopping_ = false;
+    std::thread persist_thread_;
+};
+
+} // namespace easy_compress_dlib
+
+#endif // EASY_COMPRESS_DLIB_ONLINE_SELECTOR_H
@@ -0,0 +1,61 @@
+#ifndef EASY_COMPRESS_DLIB_PARALLEL_H
+#define EASY_COMPRESS_DLIB_PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace easy_compress_dlib {
+
+// Run fn(i) for every i in [0, count) on up to `threads` threads
+// (0 = hardware concurrency). The first exception thrown is rethrown.
+template <typename Function>
+void parallel_for(std::size_t count, unsigned threads, Function&& fn) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = static_cast<unsigned>(std::min<std::size_t>(threads, count));
+    if (threads <= 1) {
+        for (std::size_t i = 0; i < count; ++i) {
+            fn(i);
+        }
+        return;
+    }
+
+    std::atomic<std::size_t> next{0};
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    auto worker = [&] {
+        for (std::size_t i = next++; i < count; i = next++) {
+            try {
+                fn(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                if (!error) {
+                    error = std::current_exception();
+                }
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(threads - 1);
+    for (unsigned t = 1; t < threads; ++t) {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (auto& w : workers) {
+        w.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+} // namespace easy_compress_dlib
+
+#endif // EASY_COMPRESS_DLIB_PARALLEL_H
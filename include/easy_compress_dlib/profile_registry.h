@@ -0,0 +1,189 @@
+#ifndef EASY_COMPRESS_DLIB_PROFILE_REGISTRY_H
+#define EASY_COMPRESS_DLIB_PROFILE_REGISTRY_H
+
+#include "compression_profile.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace easy_compress_dlib {
+
+// Immutable flat hash map from profile name to profile (open addressing, linear
+// probing). Of profiles sharing a name the first one is found, as in
+// CompressionProfiles and the profile store.
+template <typename Profile>
+class ProfileSnapshot {
+public:
+    explicit ProfileSnapshot(std::vector<Profile> profiles) : profiles_(std::move(profiles)) {
+        std::size_t capacity = 16;
+        while (capacity < profiles_.size() * 2) {
+            capacity <<= 1;
+        }
+        slots_.assign(capacity, 0);
+        mask_ = capacity - 1;
+
+        for (std::size_t i = 0; i < profiles_.size(); ++i) {
+            std::string_view name = profiles_[i].get_profile_name();
+            std::size_t slot = std::hash<std::string_view>{}(name) & mask_;
+            while (slots_[slot] != 0 && profiles_[slots_[slot] - 1].get_profile_name() != name) {
+                slot = (slot + 1) & mask_;
+            }
+            if (slots_[slot] == 0) {
+                slots_[slot] = static_cast<std::uint32_t>(i + 1);
+            }
+        }
+    }
+
+    const Profile* find(std::string_view name) const {
+        std::size_t slot = std::hash<std::string_view>{}(name) & mask_;
+        while (slots_[slot] != 0) {
+            const Profile& profile = profiles_[slots_[slot] - 1];
+            if (profile.get_profile_name() == name) {
+                return &profile;
+            }
+            slot = (slot + 1) & mask_;
+        }
+        return nullptr;
+    }
+
+    std::size_t size() const { return profiles_.size(); }
+    const std::vector<Profile>& profiles() const { return profiles_; }
+
+private:
+    std::vector<Profile> profiles_;
+    std::vector<std::uint32_t> slots_;   // index + 1 into profiles_, 0 = empty
+    std::size_t mask_ = 0;
+};
+
+// Read-optimized, concurrently readable set of compression profiles.
+//
+// Readers work on an immutable snapshot. Each thread caches a shared_ptr to the
+// current snapshot of the last few registries it used and only reloads it when
+// that registry's version changes, so a lookup is one atomic load plus a hash
+// probe, with no locking and no shared reference-count traffic. A thread
+// switching between more than local_snapshot_slots registries reloads.
+// A cached snapshot outlives its registry until the slot is reused or the
+// thread exits. Writers build a complete new snapshot and swap it in
+// atomically; readers still holding the old one keep it alive.
+template <typename Profile>
+class ProfileRegistry {
+public:
+    using Snapshot = ProfileSnapshot<Profile>;
+    using Kernel = decltype(std::declval<const Profile&>().get_kernel());
+
+    ProfileRegistry()
+        : id_(next_registry_id()), current_(std::make_shared<const Snapshot>(std::vector<Profile>{})) {}
+
+    ProfileRegistry(const ProfileRegistry&) = delete;
+    ProfileRegistry& operator=(const ProfileRegistry&) = delete;
+
+    // The current snapshot; safe to keep across reloads
+    std::shared_ptr<const Snapshot> snapshot() const {
+        return current_.load(std::memory_order_acquire);
+    }
+
+    std::optional<Kernel> try_get_kernel(std::string_view profile_name) const {
+        const Profile* profile = local_snapshot().find(profile_name);
+        if (profile == nullptr) {
+            return std::nullopt;
+        }
+        return profile->get_kernel();
+    }
+
+    // Same contract as CompressionProfiles::get_kernel_for_profile
+    Kernel get_kernel_for_profile(std::string_view profile_name) const {
+        if (auto kernel = try_get_kernel(profile_name)) {
+            return *kernel;
+        }
+        throw std::runtime_error("Profile not found");
+    }
+
+    bool contains(std::string_view profile_name) const {
+        return local_snapshot().find(profile_name) != nullptr;
+    }
+
+    std::uint64_t version() const { return version_.load(std::memory_order_acquire); }
+
+    // Replace the whole profile set
+    void publish(std::vector<Profile> profiles) {
+        current_.store(std::make_shared<const Snapshot>(std::move(profiles)), std::memory_order_release);
+        version_.fetch_add(1, std::memory_order_acq_rel);
+    }
+
+    void publish(const CompressionProfiles<Profile>& profiles) {
+        std::vector<Profile> list;
+        list.reserve(profiles.get_profiles().size());
+        for (const auto& [name, profile] : profiles.get_profiles()) {
+            list.push_back(profile);
+        }
+        publish(std::move(list));
+    }
+
+    // Load a profile file (CompressionProfiles::save_profiles format) into a new snapshot
+    void reload(const std::string& filename) {
+        CompressionProfiles<Profile> profiles;
+        profiles.load_profiles(filename);
+        publish(profiles);
+    }
+
+private:
+    static constexpr std::size_t local_snapshot_slots = 4;
+
+    static std::uint64_t next_registry_id() {
+        static std::atomic<std::uint64_t> next_id{1};
+        return next_id.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Per thread and Profile type, a few slots keyed by registry id; a new
+    // registry takes the slots in turn
+    const Snapshot& local_snapshot() const {
+        struct LocalSnapshot {
+            std::uint64_t registry_id = 0;
+            std::uint64_t version = 0;
+            std::shared_ptr<const Snapshot> snapshot;
+        };
+        struct LocalSnapshots {
+            LocalSnapshot slots[local_snapshot_slots];
+            std::size_t next = 0;
+        };
+        thread_local LocalSnapshots local;
+
+        LocalSnapshot* entry = nullptr;
+        for (auto& slot : local.slots) {
+            if (slot.registry_id == id_) {
+                entry = &slot;
+                break;
+            }
+        }
+        if (entry == nullptr) {
+            entry = &local.slots[local.next];
+            local.next = (local.next + 1) % local_snapshot_slots;
+            entry->registry_id = id_;
+            entry->snapshot.reset();
+        }
+
+        const std::uint64_t current_version = version();
+        if (!entry->snapshot || entry->version != current_version) {
+            // The version is bumped after the store, so this snapshot is at least as new
+            entry->snapshot = snapshot();
+            entry->version = current_version;
+        }
+        return *entry->snapshot;
+    }
+
+    const std::uint64_t id_;
+    std::atomic<std::shared_ptr<const Snapshot>> current_;
+    std::atomic<std::uint64_t> version_{0};
+};
+
+} // namespace easy_compress_dlib
+
+#endif // EASY_COMPRESS_DLIB_PROFILE_REGISTRY_H
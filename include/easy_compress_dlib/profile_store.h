@@ -0,0 +1,125 @@
+#ifndef EASY_COMPRESS_DLIB_PROFILE_STORE_H
+#define EASY_COMPRESS_DLIB_PROFILE_STORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace easy_compress_dlib {
+
+// Binary profile store
+//
+// A compact, memory-mappable image of a profile file that is queried in place,
+// without parsing:
+//
+//   ProfileStoreHeader
+//   ProfileStoreRecord[record_count]
+//   u32 slots[slot_count]       open-addressing hash index, record index + 1, 0 = empty
+//   char strings[strings_size]  profile names and file types
+//
+// All fields are little endian. The name hash is FNV-1a so the index does not
+// depend on the standard library that built the file.
+
+constexpr char profile_store_magic[4] = {'E', 'C', 'P', 'B'};
+constexpr std::uint32_t profile_store_version = 2;
+
+struct ProfileStoreHeader {
+    char magic[4];
+    std::uint32_t version;
+    std::uint64_t record_count;
+    std::uint64_t slot_count;        // power of two
+    std::uint64_t records_offset;
+    std::uint64_t slots_offset;
+    std::uint64_t strings_offset;
+    std::uint64_t strings_size;
+    std::uint64_t metrics_fingerprint; // kernel_metrics_fingerprint() the kernels were resolved with
+};
+
+struct ProfileStoreRecord {
+    std::uint32_t name_offset;
+    std::uint32_t name_length;
+    std::uint32_t file_type_offset;
+    std::uint32_t file_type_length;
+    double alpha;
+    std::int32_t kernel;
+    std::uint32_t name_hash;
+};
+
+static_assert(sizeof(ProfileStoreHeader) == 64);
+static_assert(sizeof(ProfileStoreRecord) == 32);
+
+constexpr std::uint32_t profile_name_hash(std::string_view name) {
+    std::uint32_t hash = 2166136261u;
+    for (char c : name) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// A profile as stored; views point into the mapped file
+struct ProfileView {
+    std::string_view profile_name;
+    std::string_view file_type;
+    double alpha;
+    int kernel;
+};
+
+// Profile to be written to a store
+struct ProfileRecord {
+    std::string profile_name;
+    std::string file_type;
+    double alpha;
+    int kernel;
+};
+
+// Throws std::length_error if the strings do not fit u32 offsets
+void write_profile_store(const std::vector<ProfileRecord>& profiles, const std::string& filename,
+                         std::uint64_t metrics_fingerprint);
+
+// Convert a CompressionProfiles CSV file into a binary store. The kernel column
+// is trusted when the file's metrics fingerprint header matches the current
+// metrics; otherwise, and for invalid kernels, kernels are re-resolved.
+// Returns the number of profiles written.
+std::size_t import_profiles_csv(const std::string& csv_filename, const std::string& store_filename);
+
+// Read-only memory-mapped store. Lookups touch only the probed slots, the
+// matching record and its strings.
+class ProfileStore {
+public:
+    // Throws std::runtime_error if the file cannot be mapped or is malformed
+    explicit ProfileStore(const std::string& filename);
+    ~ProfileStore();
+
+    ProfileStore(ProfileStore&& other) noexcept;
+    ProfileStore& operator=(ProfileStore&& other) noexcept;
+    ProfileStore(const ProfileStore&) = delete;
+    ProfileStore& operator=(const ProfileStore&) = delete;
+
+    std::optional<ProfileView> find(std::string_view profile_name) const;
+
+    // The stored kernel if it is valid and the store was written with metrics
+    // of the current fingerprint, the kernel selected now otherwise
+    std::optional<int> get_kernel_for_profile(std::string_view profile_name) const;
+
+    std::size_t size() const { return static_cast<std::size_t>(header().record_count); }
+    ProfileView at(std::size_t index) const;
+    std::uint64_t metrics_fingerprint() const { return header().metrics_fingerprint; }
+
+private:
+    const ProfileStoreHeader& header() const { return *reinterpret_cast<const ProfileStoreHeader*>(data_); }
+    const ProfileStoreRecord* records() const;
+    const std::uint32_t* slots() const;
+    ProfileView view(const ProfileStoreRecord& record) const;
+    void unmap();
+
+    const char* data_ = nullptr;
+    std::size_t size_ = 0;
+};
+
+} // namespace easy_compress_dlib
+
+#endif // EASY_COMPRESS_DLIB_PROFILE_STORE_H
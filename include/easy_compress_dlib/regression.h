@@ -0,0 +1,109 @@
+#ifndef EASY_COMPRESS_DLIB_REGRESSION_H
+#define EASY_COMPRESS_DLIB_REGRESSION_H
+
+#include "benchmark.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace easy_compress_dlib {
+
+// Performance regression checks on top of the benchmark runner
+//
+// A baseline is a set of benchmark results with their raw timings, stored per
+// subject, file type and input size. A later run of the same cases is compared
+// sample against sample: a slowdown is reported only if a Mann-Whitney U test
+// finds the timings differ, a bootstrap confidence interval of the ratio of
+// medians lies wholly above 1, and the change is larger than min_change.
+// Compressed sizes are deterministic, so any growth beyond ratio_tolerance is
+// a regression without a test.
+//
+// Baseline file, CSV:
+//
+//   # benchmark_seed=<seed>
+//   subject,file_type,input_size,compressed_size,compress_seconds,decompress_seconds
+//
+// where the timings are ';' separated lists of seconds.
+
+constexpr std::string_view baseline_seed_prefix = "# benchmark_seed=";
+
+struct RegressionOptions {
+    double significance = 0.01;        // for the U test, and 1 - confidence of the interval
+    double min_change = 0.05;          // ignore slowdowns below 5%
+    double ratio_tolerance = 0.001;    // relative growth of the compressed size
+    unsigned bootstrap_iterations = 2000;
+    std::uint64_t bootstrap_seed = 1;
+};
+
+struct MannWhitneyResult {
+    double u = 0.0;          // U statistic of the first sample
+    double z = 0.0;
+    double p_value = 1.0;    // two-sided, normal approximation with tie correction
+};
+
+// Throws std::invalid_argument if either sample is empty
+MannWhitneyResult mann_whitney_u(const std::vector<double>& a, const std::vector<double>& b);
+
+struct ConfidenceInterval {
+    double low = 0.0;
+    double high = 0.0;
+};
+
+// Percentile bootstrap interval of median(b) / median(a) at the given confidence
+// level. Throws std::invalid_argument if either sample is empty.
+ConfidenceInterval bootstrap_median_ratio(const std::vector<double>& a, const std::vector<double>& b,
+                                          double confidence, unsigned iterations, std::uint64_t seed);
+
+enum class RegressionMetric { compress_time, decompress_time, compressed_size, round_trip };
+
+struct RegressionFinding {
+    std::string subject;
+    std::string file_type;
+    std::size_t input_size = 0;
+    RegressionMetric metric = RegressionMetric::compress_time;
+    double baseline = 0.0;   // median seconds, or bytes
+    double current = 0.0;
+    double change = 0.0;     // current / baseline - 1
+    double p_value = 1.0;    // 0 for compressed size and round trip
+    ConfidenceInterval ratio;
+    bool regression = false;
+    bool improvement = false;
+};
+
+const char* regression_metric_name(RegressionMetric metric);
+
+// Findings for one case, whatever the subject names; used for A/B runs
+std::vector<RegressionFinding> compare_result(const BenchmarkResult& baseline, const BenchmarkResult& current,
+                                              const RegressionOptions& options = {});
+
+// One finding per metric for every case present in both, plus a round_trip
+// regression for a case that no longer decompresses to its input. Cases
+// without a counterpart are ignored.
+std::vector<RegressionFinding> compare_results(const std::vector<BenchmarkResult>& baseline,
+                                               const std::vector<BenchmarkResult>& current,
+                                               const RegressionOptions& options = {});
+
+void save_baseline(const std::string& filename, const std::vector<BenchmarkResult>& results, std::uint64_t seed);
+// Throws std::runtime_error if the file cannot be opened; malformed rows are
+// reported to std::cerr and skipped
+std::vector<BenchmarkResult> load_baseline(const std::string& filename, std::uint64_t* seed = nullptr);
+
+// Run a and b on the same input with their repetitions interleaved (a, b, a,
+// b, ...), so drift in clock speed or background load hits both alike. Any
+// two subjects work, e.g. compress_lz77_with_buffer over two sliding_buffer or
+// match finder implementations; compare_result(first, second) tells whether b
+// is slower.
+std::pair<BenchmarkResult, BenchmarkResult> run_ab_case(const BenchmarkSubject& a, const BenchmarkSubject& b,
+                                                        std::string_view file_type, const std::string& input,
+                                                        const BenchmarkOptions& options);
+
+// Restrict the calling thread to one CPU to cut scheduler noise. Returns false
+// where affinity cannot be set.
+bool pin_to_cpu(unsigned cpu);
+
+} // namespace easy_compress_dlib
+
+#endif // EASY_COMPRESS_DLIB_REGRESSION_H
@@ -0,0 +1,39 @@
+#ifndef EASY_COMPRESS_DLIB_ROLLING_HASH_H
+#define EASY_COMPRESS_DLIB_ROLLING_HASH_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace easy_compress_dlib {
+
+// Gear rolling hash: h = (h << 1) + gear[byte]. A byte's contribution is
+// shifted out after 64 steps, so the hash covers the last 64 bytes without
+// having to remove anything. Its high bits depend on the most bytes, so
+// callers test and index with those.
+
+constexpr std::size_t gear_window = 64;
+
+constexpr std::array<std::uint64_t, 256> make_gear_table() {
+    // splitmix64, so the table is fixed across builds and platforms
+    std::array<std::uint64_t, 256> table{};
+    std::uint64_t state = 0x9E3779B97F4A7C15ull;
+    for (auto& entry : table) {
+        state += 0x9E3779B97F4A7C15ull;
+        std::uint64_t z = state;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        entry = z ^ (z >> 31);
+    }
+    return table;
+}
+
+inline constexpr std::array<std::uint64_t, 256> gear_table = make_gear_table();
+
+constexpr std::uint64_t gear_roll(std::uint64_t hash, unsigned char byte) {
+    return (hash << 1) + gear_table[byte];
+}
+
+} // namespace easy_compress_dlib
+
+#endif // EASY_COMPRESS_DLIB_ROLLING_HASH_H
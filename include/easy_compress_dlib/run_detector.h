@@ -0,0 +1,36 @@
+#ifndef EASY_COMPRESS_DLIB_RUN_DETECTOR_H
+#define EASY_COMPRESS_DLIB_RUN_DETECTOR_H
+
+#include <cstddef>
+#include <string_view>
+
+namespace easy_compress_dlib {
+
+// Runs of identical bytes
+//
+// Any run of 15 or more bytes covers a whole 8-byte word at a multiple of 8,
+// so find_run tests one word per 8 bytes (equal to its first byte broadcast)
+// and only looks closer at uniform words.
+
+constexpr std::size_t min_detectable_run = 16;
+
+struct ByteRun {
+    std::size_t position;
+    std::size_t length;     // 0 if there is no run
+    unsigned char value;
+};
+
+// Length of the run of data[position] that starts at position, compared 8
+// bytes at a time
+std::size_t run_length_at(std::string_view data, std::size_t position);
+
+// First run of at least min_length bytes starting at or after from; its length
+// is 0 if there is none. min_length below min_detectable_run is raised to it.
+ByteRun find_run(std::string_view data, std::size_t from, std::size_t min_length);
+
+// True if data is one run (and not empty)
+bool is_single_run(std::string_view data);
+
+} // namespace easy_compress_dlib
+
+#endif // EASY_COMPRESS_DLIB_RUN_DETECTOR_H
@@ -0,0 +1,46 @@
+#ifndef EASY_COMPRESS_DLIB_SELECTION_CACHE_H
+#define EASY_COMPRESS_DLIB_SELECTION_CACHE_H
+
+#include "kernel_metrics_table.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace easy_compress_dlib {
+
+// Memoized kernel selections keyed by (file type, alpha bucket).
+//
+// Every slot packs the selected kernel with the metrics version it was computed
+// for, so reloading the metrics invalidates the whole cache just by bumping the
+// version. A hit is a single atomic load; a miss computes and stores, and two
+// threads racing on the same miss simply store the same value.
+class KernelSelectionCache {
+public:
+    template <typename Compute>
+    int get_or_compute(FileTypeId type, std::size_t bucket, std::uint32_t version, Compute&& compute) {
+        auto& slot = slots_[static_cast<std::size_t>(type) * alpha_buckets + bucket];
+        const std::uint64_t tag = static_cast<std::uint64_t>(version) + 1;   // 0 marks an empty slot
+
+        std::uint64_t entry = slot.load(std::memory_order_acquire);
+        if ((entry >> 8) == tag) {
+            return static_cast<int>(entry & 0xFF);
+        }
+        int kernel = compute();
+        slot.store((tag << 8) | static_cast<std::uint64_t>(kernel & 0xFF), std::memory_order_release);
+        return kernel;
+    }
+
+    void clear() {
+        for (auto& slot : slots_) {
+            slot.store(0, std::memory_order_relaxed);
+        }
+    }
+
+private:
+    std::array<std::atomic<std::uint64_t>, file_type_count * alpha_buckets> slots_{};
+};
+
+} // namespace easy_compress_dlib
+
+#endif // EASY_COMPRESS_DLIB_SELECTION_CACHE_H
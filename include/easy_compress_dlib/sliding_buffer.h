@@ -1,33 +1,67 @@
-#include <vector>
-
-class sliding_buffer {
-public:
-    sliding_buffer() : buffer_(1024) {} // Initialize with a reasonable default size
-
-    void set_size(size_t size) {
-        buffer_.resize(size);
-    }
-
-    void rotate_left(size_t n) {
-        std::rotate(buffer_.begin(), buffer_.begin() + n, buffer_.end());
-    }
-
-    size_t get_element_id(size_t index) const {
-        return index;
-    }
-
-    size_t size() const {
-        return buffer_.size();
-    }
-
-    unsigned char& operator[](size_t index) {
-        return buffer_[index];
-    }
-
-    const unsigned char& operator[](size_t index) const {
-        return buffer_[index];
-    }
-
-private:
-    std::vector<unsigned char> buffer_;
-};
+#ifndef EASY_COMPRESS_DLIB_SLIDING_BUFFER_H
+#define EASY_COMPRESS_DLIB_SLIDING_BUFFER_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Circular buffer for the lz77_buffer kernels, following dlib's sliding_buffer:
+// set_size takes the base 2 logarithm of the size, rotations only move the start
+// of the buffer, and element ids stay fixed while the buffer rotates
+// (lz77_buffer_kernel_2 keys its hash chains on them).
+//
+// rotate_left(n) moves every element n places up: #(*this)[(i+n)%size()] == (*this)[i].
+// The kernels keep the lookahead buffer below the history, so this is what
+// moves symbols from one into the other.
+//
+// The storage comes from Allocator; the kernels pass theirs to the allocator
+// constructor (lz77_make_sliding_buffer in lz77_buffer_policies.h).
+template <typename Allocator = std::allocator<unsigned char>>
+class basic_sliding_buffer {
+public:
+    basic_sliding_buffer() : buffer_(1024), mask_(1023), start_(0) {} // Initialize with a reasonable default size
+    explicit basic_sliding_buffer(const Allocator& allocator) : buffer_(1024, 0, allocator), mask_(1023), start_(0) {}
+
+    void set_size(size_t exp_size) {
+        buffer_.assign(size_t(1) << exp_size, 0);
+        mask_ = buffer_.size() - 1;
+        start_ = 0;
+    }
+
+    void rotate_left(size_t n) {
+        start_ = (start_ - n) & mask_;
+    }
+
+    void rotate_right(size_t n) {
+        start_ = (start_ + n) & mask_;
+    }
+
+    size_t get_element_id(size_t index) const {
+        return (start_ + index) & mask_;
+    }
+
+    size_t get_element_index(size_t element_id) const {
+        return (element_id - start_) & mask_;
+    }
+
+    size_t size() const {
+        return buffer_.size();
+    }
+
+    unsigned char& operator[](size_t index) {
+        return buffer_[(start_ + index) & mask_];
+    }
+
+    const unsigned char& operator[](size_t index) const {
+        return buffer_[(start_ + index) & mask_];
+    }
+
+private:
+    std::vector<unsigned char, Allocator> buffer_;
+    size_t mask_;
+    size_t start_;
+};
+
+using sliding_buffer = basic_sliding_buffer<>;
+
+#endif // EASY_COMPRESS_DLIB_SLIDING_BUFFER_H
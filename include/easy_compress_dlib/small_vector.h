@@ -0,0 +1,293 @@
+#ifndef SMALL_VECTOR_H
+#define SMALL_VECTOR_H
+
+#include "custom_vector.h"
+
+// Vector with room for N elements inside the object. It only allocates, from
+// Allocator, once it grows past N, and never goes back to the inline buffer;
+// clear() keeps whatever storage it has. Same interface as Vector, plus
+// isInline(). Moving an inline SmallVector moves its elements one by one.
+template <typename T, size_t N, typename Allocator = std::allocator<T>>
+class SmallVector {
+    static_assert(N > 0, "SmallVector needs inline capacity, use Vector otherwise");
+
+private:
+    using alloc_traits = std::allocator_traits<Allocator>;
+
+    [[no_unique_address]] Allocator alloc;
+    T* data;
+    size_t size;
+    size_t capacity;
+    alignas(T) unsigned char storage[N * sizeof(T)];
+
+    T* inlineData() { return reinterpret_cast<T*>(storage); }
+
+    void destroy_elements(T* first, T* last) noexcept {
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            for (; first != last; ++first) {
+                alloc_traits::destroy(alloc, first);
+            }
+        }
+    }
+
+    void free_storage() noexcept {
+        if (!isInline()) {
+            alloc_traits::deallocate(alloc, data, capacity);
+        }
+        data = inlineData();
+        capacity = N;
+    }
+
+    // Moves the elements into raw storage at dest and ends their lifetime
+    // here; copies instead when the move could throw
+    void relocate_elements(T* dest) {
+        if constexpr (std::is_trivially_copyable_v<T>) {
+            if (size != 0) {
+                std::memcpy(dest, data, size * sizeof(T));
+            }
+        } else {
+            size_t i = 0;
+            try {
+                for (; i < size; ++i) {
+                    alloc_traits::construct(alloc, dest + i, std::move_if_noexcept(data[i]));
+                }
+            } catch (...) {
+                destroy_elements(dest, dest + i);
+                throw;
+            }
+            destroy_elements(data, data + size);
+        }
+    }
+
+    void reallocate(size_t new_capacity) {
+        T* new_data = alloc_traits::allocate(alloc, new_capacity);
+        try {
+            relocate_elements(new_data);
+        } catch (...) {
+            alloc_traits::deallocate(alloc, new_data, new_capacity);
+            throw;
+        }
+        free_storage();
+        data = new_data;
+        capacity = new_capacity;
+    }
+
+    size_t grown_capacity(size_t min_capacity) const {
+        return std::max(min_capacity, capacity * 2);
+    }
+
+    // emplace_back when full: the new element is built before the old ones
+    // move, so args may refer into this vector
+    template <typename... Args>
+    T& emplace_back_grow(Args&&... args) {
+        const size_t new_capacity = grown_capacity(size + 1);
+        T* new_data = alloc_traits::allocate(alloc, new_capacity);
+        try {
+            alloc_traits::construct(alloc, new_data + size, std::forward<Args>(args)...);
+        } catch (...) {
+            alloc_traits::deallocate(alloc, new_data, new_capacity);
+            throw;
+        }
+        try {
+            relocate_elements(new_data);
+        } catch (...) {
+            alloc_traits::destroy(alloc, new_data + size);
+            alloc_traits::deallocate(alloc, new_data, new_capacity);
+            throw;
+        }
+        free_storage();
+        data = new_data;
+        capacity = new_capacity;
+        return data[size++];
+    }
+
+    // Appends copies of other's elements, which must fit
+    void append_copies(const SmallVector& other) {
+        if constexpr (std::is_trivially_copyable_v<T>) {
+            if (other.size != 0) {
+                std::memcpy(data, other.data, other.size * sizeof(T));
+            }
+            size = other.size;
+        } else {
+            for (; size < other.size; ++size) {
+                alloc_traits::construct(alloc, data + size, other.data[size]);
+            }
+        }
+    }
+
+    // Takes other's elements, stealing its heap storage when that is allowed
+    void take(SmallVector& other) {
+        const bool steal = !other.isInline() &&
+                           (alloc_traits::propagate_on_container_move_assignment::value || alloc == other.alloc);
+        if (steal) {
+            data = other.data;
+            size = other.size;
+            capacity = other.capacity;
+            other.data = other.inlineData();
+            other.capacity = N;
+        } else {
+            reserve(other.size);
+            for (; size < other.size; ++size) {
+                alloc_traits::construct(alloc, data + size, std::move(other.data[size]));
+            }
+            other.destroy_elements(other.data, other.data + other.size);
+        }
+        other.size = 0;
+    }
+
+public:
+    using allocator_type = Allocator;
+
+    // Constructors
+    SmallVector() : alloc(), data(inlineData()), size(0), capacity(N) {}
+    explicit SmallVector(const Allocator& allocator) : alloc(allocator), data(inlineData()), size(0), capacity(N) {}
+    explicit SmallVector(size_t initial_capacity, const Allocator& allocator = Allocator())
+        : alloc(allocator), data(inlineData()), size(0), capacity(N) {
+        reserve(initial_capacity);
+    }
+
+    // Variadic template constructor to support uniform initialization
+    template <typename... Args>
+        requires ((!std::is_same_v<std::remove_cvref_t<Args>, Allocator> && ...) &&
+                  (sizeof...(Args) != 1 || (!std::is_same_v<std::remove_cvref_t<Args>, SmallVector> && ...)))
+    explicit SmallVector(Args&&... args) : alloc(), data(inlineData()), size(0), capacity(N) {
+        try {
+            reserve(sizeof...(Args));
+            (emplace_back(std::forward<Args>(args)), ...);
+        } catch (...) {
+            clear();
+            free_storage();
+            throw;
+        }
+    }
+
+    // Destructor
+    ~SmallVector() {
+        clear();
+        free_storage();
+    }
+
+    // Copy constructor and assignment operator
+    SmallVector(const SmallVector& other) requires Copyable<T>
+        : alloc(alloc_traits::select_on_container_copy_construction(other.alloc)),
+          data(inlineData()), size(0), capacity(N) {
+        try {
+            reserve(other.size);
+            append_copies(other);
+        } catch (...) {
+            clear();
+            free_storage();
+            throw;
+        }
+    }
+
+    SmallVector& operator=(const SmallVector& other) requires Copyable<T> {
+        if (this != &other) {
+            clear();
+            if constexpr (alloc_traits::propagate_on_container_copy_assignment::value) {
+                if (!(alloc == other.alloc)) {
+                    free_storage();
+                }
+                alloc = other.alloc;
+            }
+            reserve(other.size);
+            append_copies(other);
+        }
+        return *this;
+    }
+
+    // Move constructor and assignment operator
+    SmallVector(SmallVector&& other) noexcept(std::is_nothrow_move_constructible_v<T>) requires MoveAble<T>
+        : alloc(other.alloc), data(inlineData()), size(0), capacity(N) {
+        take(other);
+    }
+
+    SmallVector& operator=(SmallVector&& other) requires MoveAble<T> {
+        if (this != &other) {
+            clear();
+            if constexpr (alloc_traits::propagate_on_container_move_assignment::value) {
+                // Storage from the old allocator cannot outlive it
+                if (!other.isInline() || !(alloc == other.alloc)) {
+                    free_storage();
+                }
+                alloc = std::move(other.alloc);
+            } else if (!other.isInline() && alloc == other.alloc) {
+                free_storage();
+            }
+            take(other);
+        }
+        return *this;
+    }
+
+    // Template friend function to allow access to private members
+    template <typename U, size_t M, typename A>
+    friend void swapElements(SmallVector<U, M, A>& v1, SmallVector<U, M, A>& v2, size_t index1, size_t index2);
+
+    // Member functions
+    size_t getSize() const { return size; }
+    size_t getCapacity() const { return capacity; }
+    Allocator get_allocator() const { return alloc; }
+    T* getData() { return data; }
+    const T* getData() const { return data; }
+    bool isInline() const { return data == reinterpret_cast<const T*>(storage); }
+
+    template <typename... Args>
+    T& emplace_back(Args&&... args) {
+        if (size == capacity) {
+            return emplace_back_grow(std::forward<Args>(args)...);
+        }
+        alloc_traits::construct(alloc, data + size, std::forward<Args>(args)...);
+        return data[size++];
+    }
+
+    void push_back(const T& value) {
+        emplace_back(value);
+    }
+
+    void push_back(T&& value) {
+        emplace_back(std::move(value));
+    }
+
+    void reserve(size_t new_capacity) {
+        if (new_capacity > capacity) {
+            reallocate(new_capacity);
+        }
+    }
+
+    // Sets the size to n without constructing the new elements
+    void resize_uninitialized(size_t n)
+        requires std::is_trivially_default_constructible_v<T> && std::is_trivially_destructible_v<T>
+    {
+        if (n > capacity) {
+            reallocate(grown_capacity(n));
+        }
+        size = n;
+    }
+
+    void clear() noexcept {
+        destroy_elements(data, data + size);
+        size = 0;
+    }
+
+    T& operator[](size_t index) {
+        return data[index];
+    }
+
+    const T& operator[](size_t index) const {
+        return data[index];
+    }
+
+    // Rotate the vector to the left by n positions
+    void rotate(size_t n) {
+        n %= size; // Handle cases where n is greater than size
+        std::rotate(data, data + n, data + size);
+    }
+};
+
+// Template friend function to swap elements in two vectors
+template <typename U, size_t M, typename A>
+void swapElements(SmallVector<U, M, A>& v1, SmallVector<U, M, A>& v2, size_t index1, size_t index2) {
+    std::swap(v1[index1], v2[index2]);
+}
+
+#endif // SMALL_VECTOR_H
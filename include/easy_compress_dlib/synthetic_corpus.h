@@ -0,0 +1,30 @@
+#ifndef EASY_COMPRESS_DLIB_SYNTHETIC_CORPUS_H
+#define EASY_COMPRESS_DLIB_SYNTHETIC_CORPUS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace easy_compress_dlib {
+
+// Deterministic synthetic stand-ins for the file types of the kernel metrics
+// (see known_file_types), for benchmarks that must not depend on corpus files:
+//
+//   text, tech, poem   English-like prose with word frequencies skewed towards
+//                      a small vocabulary; tech adds section numbers and
+//                      acronyms, poem short lines and stanzas
+//   play               speaker names and indented dialogue
+//   html, Csrc, list   markup, C and Lisp source
+//   man                troff macros and prose
+//   Excl               fixed-size little endian spreadsheet cell records
+//   fax                1728-pixel bilevel scanlines, mostly white
+//   SPRC               big endian SPARC-like instruction words and a string table
+//
+// The output depends only on the arguments, on every platform. Throws
+// std::invalid_argument for an unknown file type.
+std::string generate_corpus(std::string_view file_type, std::size_t size, std::uint64_t seed = 0);
+
+} // namespace easy_compress_dlib
+
+#endif // EASY_COMPRESS_DLIB_SYNTHETIC_CORPUS_H
@@ -0,0 +1,86 @@
+#ifndef EASY_COMPRESS_DLIB_THREAD_POOL_H
+#define EASY_COMPRESS_DLIB_THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace easy_compress_dlib {
+
+// Work-stealing thread pool
+//
+// Every worker owns a task queue. A task submitted from a worker goes to that
+// worker's queue, other tasks are spread round-robin. A worker takes its newest
+// task first and, when its own queue is empty, steals the oldest task of
+// another queue, so large jobs submitted early are split up by idle workers
+// while freshly spawned work stays on the thread whose caches hold its input.
+class ThreadPool {
+public:
+    // threads = 0: hardware concurrency
+    explicit ThreadPool(unsigned threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned size() const { return static_cast<unsigned>(workers_.size()); }
+
+    // The task must not throw; use a TaskGroup to collect exceptions
+    void submit(std::function<void()> task);
+
+    // Run one queued task on the calling thread. Returns false if there was none.
+    bool run_pending();
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    bool pop(std::size_t self, std::function<void()>& task);
+    void worker_loop(std::size_t index);
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> workers_;
+    std::atomic<std::size_t> pending_{0};
+    std::atomic<std::size_t> next_queue_{0};
+    std::mutex sleep_mutex_;
+    std::condition_variable wake_;
+    bool stopping_ = false;
+};
+
+// A set of tasks on a pool that can be waited for together. wait() runs queued
+// tasks on the calling thread while it waits, so a task may wait on a group of
+// its own. The first exception thrown by a task is rethrown by wait().
+class TaskGroup {
+public:
+    explicit TaskGroup(ThreadPool& pool) : pool_(pool) {}
+    // Waits for outstanding tasks; exceptions are dropped
+    ~TaskGroup();
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    void run(std::function<void()> task);
+    void wait();
+
+private:
+    void finish_one();
+
+    ThreadPool& pool_;
+    std::atomic<std::size_t> outstanding_{0};
+    std::mutex mutex_;
+    std::condition_variable done_;
+    std::exception_ptr error_;
+};
+
+} // namespace easy_compress_dlib
+
+#endif // EASY_COMPRESS_DLIB_THREAD_POOL_H
@@ -0,0 +1,141 @@
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "../include/easy_compress_dlib/benchmark.h"
+#include "../include/easy_compress_dlib/hw_profiler.h"
+#include "../include/easy_compress_dlib/kernel_metrics_table.h"
+
+using namespace easy_compress_dlib;
+
+// Usage: benchmark [--sizes 1K,64K,1M,1G] [--types text,Csrc,...] [--subjects 1a,lz77,...]
+//                  [--repetitions N] [--seed N] [--kernels-only | --buffers-only] [--output file.json]
+//                  [--profile]
+//
+// Runs every kernel and every lz77_buffer instantiation over the synthetic
+// corpus and writes the results as JSON to stdout or the output file.
+// Progress goes to stderr. --profile adds per-byte hardware counts to every
+// result and prints the per-region profile (hw_profiler.h) to stderr.
+
+namespace {
+
+std::vector<std::string> split_list(const std::string& list) {
+    std::vector<std::string> items;
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+// 64K, 1M, 1G or plain bytes
+std::size_t parse_size(const std::string& text) {
+    std::size_t pos = 0;
+    std::size_t value = std::stoull(text, &pos);
+    const std::string suffix = text.substr(pos);
+    if (suffix == "K" || suffix == "k") {
+        value <<= 10;
+    } else if (suffix == "M" || suffix == "m") {
+        value <<= 20;
+    } else if (suffix == "G" || suffix == "g") {
+        value <<= 30;
+    } else if (!suffix.empty()) {
+        throw std::invalid_argument("Bad size: " + text);
+    }
+    return value;
+}
+
+void report_progress(const BenchmarkSubject& subject, std::string_view file_type, std::size_t size) {
+    std::cerr << subject.name << " " << file_type << " " << size << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    BenchmarkOptions options;
+    std::vector<std::string> only_subjects;
+    bool kernels = true;
+    bool buffers = true;
+    std::string output_path;
+    bool profile = false;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) {
+                    throw std::invalid_argument("Missing value for " + arg);
+                }
+                return argv[++i];
+            };
+            if (arg == "--sizes") {
+                options.sizes.clear();
+                for (const auto& size : split_list(value())) {
+                    options.sizes.push_back(parse_size(size));
+                }
+            } else if (arg == "--types") {
+                options.file_types = split_list(value());
+                for (const auto& type : options.file_types) {
+                    if (!parse_file_type(type)) {
+                        throw std::invalid_argument("Unknown file type: " + type);
+                    }
+                }
+            } else if (arg == "--subjects") {
+                only_subjects = split_list(value());
+            } else if (arg == "--repetitions") {
+                options.repetitions = static_cast<unsigned>(std::stoul(value()));
+            } else if (arg == "--seed") {
+                options.seed = std::stoull(value());
+            } else if (arg == "--kernels-only") {
+                buffers = false;
+            } else if (arg == "--buffers-only") {
+                kernels = false;
+            } else if (arg == "--output") {
+                output_path = value();
+            } else if (arg == "--profile") {
+                profile = true;
+            } else {
+                throw std::invalid_argument("Unknown option: " + arg);
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 2;
+    }
+
+    std::vector<BenchmarkSubject> subjects;
+    if (kernels) {
+        subjects = kernel_subjects();
+    }
+    if (buffers) {
+        for (auto& subject : lz77_buffer_subjects()) {
+            subjects.push_back(subject);
+        }
+    }
+    if (!only_subjects.empty()) {
+        std::erase_if(subjects, [&](const BenchmarkSubject& subject) {
+            return std::find(only_subjects.begin(), only_subjects.end(), subject.name) == only_subjects.end();
+        });
+    }
+
+    if (profile) {
+        options.hardware_counters = true;
+        set_profiling(true);
+    }
+    const std::string json = benchmark_results_json(run_benchmarks(subjects, options, report_progress), options);
+    if (profile) {
+        std::cerr << profile_report(collect_profile());
+    }
+    if (output_path.empty()) {
+        std::cout << json;
+    } else {
+        std::ofstream(output_path) << json;
+    }
+    return 0;
+}
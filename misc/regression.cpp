@@ -0,0 +1,203 @@
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "../include/easy_compress_dlib/kernel_metrics_table.h"
+#include "../include/easy_compress_dlib/regression.h"
+#include "../include/easy_compress_dlib/synthetic_corpus.h"
+
+using namespace easy_compress_dlib;
+
+// Usage:
+//   regression record <baseline.csv> [--sizes 1K,64K] [--types text,...] [--subjects 1a,lz77,...]
+//   regression check <baseline.csv> [--significance 0.01] [--min-change 0.05]
+//   regression ab <subject_a> <subject_b> [--sizes ...] [--types ...]
+// Common options: [--repetitions N] [--seed N] [--cpu N]
+//
+// record runs the benchmark and stores the timings as a baseline. check reruns
+// the cases of a baseline and exits with status 1 if any of them regressed.
+// ab runs two subjects interleaved on the same inputs and reports whether the
+// second is slower, e.g. lz77_buffer_kernel_2 against lz77_buffer_kernel_c<kernel_2>.
+
+namespace {
+
+std::vector<std::string> split_list(const std::string& list) {
+    std::vector<std::string> items;
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+std::size_t parse_size(const std::string& text) {
+    std::size_t pos = 0;
+    std::size_t value = std::stoull(text, &pos);
+    const std::string suffix = text.substr(pos);
+    if (suffix == "K" || suffix == "k") {
+        value <<= 10;
+    } else if (suffix == "M" || suffix == "m") {
+        value <<= 20;
+    } else if (suffix == "G" || suffix == "g") {
+        value <<= 30;
+    } else if (!suffix.empty()) {
+        throw std::invalid_argument("Bad size: " + text);
+    }
+    return value;
+}
+
+std::vector<BenchmarkSubject> all_subjects() {
+    std::vector<BenchmarkSubject> subjects = kernel_subjects();
+    for (auto& subject : lz77_buffer_subjects()) {
+        subjects.push_back(subject);
+    }
+    return subjects;
+}
+
+const BenchmarkSubject& find_subject(const std::vector<BenchmarkSubject>& subjects, const std::string& name) {
+    for (const auto& subject : subjects) {
+        if (subject.name == name) {
+            return subject;
+        }
+    }
+    throw std::invalid_argument("Unknown subject: " + name);
+}
+
+// Returns true if any finding is a regression
+bool report(const std::vector<RegressionFinding>& findings, bool verbose) {
+    bool regressed = false;
+    for (const auto& f : findings) {
+        regressed = regressed || f.regression;
+        if (!verbose && !f.regression && !f.improvement) {
+            continue;
+        }
+        const char* status = f.regression ? "REGRESSION" : f.improvement ? "improved" : "same";
+        std::printf("%-10s %-32s %-5s %10zu %-16s %12.6g -> %-12.6g %+7.2f%%  p=%.4g  ratio=[%.3f, %.3f]\n", status,
+                    f.subject.c_str(), f.file_type.c_str(), f.input_size, regression_metric_name(f.metric),
+                    f.baseline, f.current, 100 * f.change, f.p_value, f.ratio.low, f.ratio.high);
+    }
+    return regressed;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::cerr << "Usage: regression record|check <baseline.csv> [options] | ab <subject_a> <subject_b> [options]"
+                  << std::endl;
+        return 2;
+    }
+    const std::string mode = argv[1];
+    BenchmarkOptions options;
+    options.repetitions = 15;   // the U test needs a few samples per side to reach significance
+    RegressionOptions regression;
+    std::vector<std::string> only_subjects;
+    std::vector<std::string> positional;
+    int cpu = -1;
+
+    try {
+        for (int i = 2; i < argc; ++i) {
+            const std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) {
+                    throw std::invalid_argument("Missing value for " + arg);
+                }
+                return argv[++i];
+            };
+            if (arg == "--sizes") {
+                options.sizes.clear();
+                for (const auto& size : split_list(value())) {
+                    options.sizes.push_back(parse_size(size));
+                }
+            } else if (arg == "--types") {
+                options.file_types = split_list(value());
+            } else if (arg == "--subjects") {
+                only_subjects = split_list(value());
+            } else if (arg == "--repetitions") {
+                options.repetitions = static_cast<unsigned>(std::stoul(value()));
+            } else if (arg == "--seed") {
+                options.seed = std::stoull(value());
+            } else if (arg == "--cpu") {
+                cpu = std::stoi(value());
+            } else if (arg == "--significance") {
+                regression.significance = std::stod(value());
+            } else if (arg == "--min-change") {
+                regression.min_change = std::stod(value());
+            } else if (arg.compare(0, 2, "--") == 0) {
+                throw std::invalid_argument("Unknown option: " + arg);
+            } else {
+                positional.push_back(arg);
+            }
+        }
+
+        if (cpu >= 0 && !pin_to_cpu(static_cast<unsigned>(cpu))) {
+            std::cerr << "Could not pin to CPU " << cpu << ", running unpinned" << std::endl;
+        }
+        const std::vector<BenchmarkSubject> subjects = all_subjects();
+
+        if (mode == "record" && positional.size() == 1) {
+            std::vector<BenchmarkSubject> selected;
+            for (const auto& subject : subjects) {
+                if (only_subjects.empty() ||
+                    std::find(only_subjects.begin(), only_subjects.end(), subject.name) != only_subjects.end()) {
+                    selected.push_back(subject);
+                }
+            }
+            save_baseline(positional[0], run_benchmarks(selected, options), options.seed);
+            return 0;
+        }
+
+        if (mode == "check" && positional.size() == 1) {
+            const std::vector<BenchmarkResult> baseline = load_baseline(positional[0], &options.seed);
+            std::map<std::pair<std::string, std::size_t>, std::vector<const BenchmarkResult*>> by_input;
+            for (const auto& result : baseline) {
+                by_input[{result.file_type, result.input_size}].push_back(&result);
+            }
+            std::vector<BenchmarkResult> current;
+            for (const auto& [key, cases] : by_input) {
+                const std::string input = generate_corpus(key.first, key.second, options.seed);
+                for (const BenchmarkResult* result : cases) {
+                    current.push_back(run_benchmark_case(find_subject(subjects, result->subject), key.first, input,
+                                                         options));
+                }
+            }
+            return report(compare_results(baseline, current, regression), false) ? 1 : 0;
+        }
+
+        if (mode == "ab" && positional.size() == 2) {
+            const BenchmarkSubject& a = find_subject(subjects, positional[0]);
+            const BenchmarkSubject& b = find_subject(subjects, positional[1]);
+            std::vector<std::string> file_types = options.file_types;
+            if (file_types.empty()) {
+                file_types.assign(known_file_types.begin(), known_file_types.end());
+            }
+            std::vector<RegressionFinding> findings;
+            for (std::size_t size : options.sizes) {
+                if (size > a.max_input_size || size > b.max_input_size) {
+                    continue;
+                }
+                for (const auto& file_type : file_types) {
+                    const std::string input = generate_corpus(file_type, size, options.seed);
+                    const auto [result_a, result_b] = run_ab_case(a, b, file_type, input, options);
+                    for (auto& finding : compare_result(result_a, result_b, regression)) {
+                        findings.push_back(std::move(finding));
+                    }
+                }
+            }
+            report(findings, true);
+            return 0;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 2;
+    }
+
+    std::cerr << "Unknown mode or wrong number of arguments: " << mode << std::endl;
+    return 2;
+}
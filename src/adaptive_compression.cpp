@@ -0,0 +1,151 @@
+#include "../include/easy_compress_dlib/adaptive_compression.h"
+#include "../include/easy_compress_dlib/block_classifier.h"
+#include "../include/easy_compress_dlib/filters.h"
+#include "../include/easy_compress_dlib/kernel_selection.h"
+#include "../include/easy_compress_dlib/kernel_table.h"
+#include "../include/easy_compress_dlib/lz77_codec.h"
+#include "../include/easy_compress_dlib/memory_budget.h"
+#include "../include/easy_compress_dlib/parallel.h"
+#include "../include/easy_compress_dlib/run_detector.h"
+#include <algorithm>
+#include <stdexcept>
+#include <string_view>
+
+namespace easy_compress_dlib {
+
+namespace {
+
+// Compress block i of input; returns its block flags. Only the raw data of the
+// previous block is needed for priming, never its compressed output.
+std::uint8_t compress_block(std::string_view input, std::size_t i, int kernel_index,
+                            const AdaptiveOptions& options, const Lz77Config& lz77, std::string& payload) {
+    std::string_view block = input.substr(i * options.block_size, options.block_size);
+    if (is_single_run(block)) {
+        payload.assign(1, block[0]);
+        return block_flag_run;
+    }
+
+    std::uint8_t flags = 0;
+    FilterChain filters;
+    std::string filtered;
+    if (options.filters) {
+        filters = choose_filters(block);
+        if (!filters.empty()) {
+            apply_filters(filters, block, filtered);
+            block = filtered;
+            flags |= block_flag_filtered;
+        }
+    }
+
+    std::string compressed;
+    if (options.cross_block_window && i != 0 && kernel_index == lz77_kernel_index) {
+        std::string_view previous = input.substr((i - 1) * options.block_size, options.block_size);
+        compress_lz77_primed(previous, block, compressed, lz77);
+        flags |= block_flag_primed;
+    } else if (kernel_index == lz77_kernel_index && lz77 != Lz77Config{}) {
+        compress_lz77(block, compressed, lz77);
+    } else {
+        compress_with_kernel(kernel_index, std::string(block), compressed);
+    }
+
+    if (flags & block_flag_filtered) {
+        payload.clear();
+        put_filter_header(payload, filters);
+        payload += compressed;
+    } else {
+        payload.swap(compressed);
+    }
+    return flags;
+}
+
+void write_blocks(const std::string& input, std::string& output, const AdaptiveOptions& options,
+                  const std::vector<int>& kernels, const std::vector<std::uint8_t>& flags,
+                  const std::vector<std::string>& payloads) {
+    output.clear();
+    begin_block_stream(output);
+    for (std::size_t i = 0; i < kernels.size(); ++i) {
+        std::size_t raw_size = std::min(options.block_size, input.size() - i * options.block_size);
+        append_compressed_block(output, kernels[i], flags[i], raw_size, payloads[i]);
+    }
+    end_block_stream(output);
+}
+
+std::size_t block_count(const std::string& input, const AdaptiveOptions& options) {
+    if (options.block_size == 0) {
+        throw std::invalid_argument("Block size must be non-zero");
+    }
+    if (options.block_size > max_block_size) {
+        throw std::invalid_argument("Block size exceeds the block stream's 32-bit size field");
+    }
+    return (input.size() + options.block_size - 1) / options.block_size;
+}
+
+} // namespace
+
+std::vector<int> compress_adaptive(const std::string& input, std::string& output, double alpha,
+                                   const AdaptiveOptions& options) {
+    // Priming only applies to LZ77, which kernel_selection never returns
+    if (options.cross_block_window) {
+        throw std::invalid_argument("cross_block_window requires compress_blocks with the LZ77 kernel");
+    }
+    const std::size_t count = block_count(input, options);
+    const std::string_view view(input);
+
+    std::vector<int> kernels(count);
+    std::vector<std::uint8_t> flags(count);
+    std::vector<std::string> payloads(count);
+    const Lz77Config lz77 = lz77_config_for_budget(options.memory_limit, options.threads, options.block_size);
+    MemoryBudget budget(options.memory_limit);
+    parallel_for(count, options.threads, [&](std::size_t i) {
+        std::string_view block = view.substr(i * options.block_size, options.block_size);
+        if (is_single_run(block)) {
+            kernels[i] = lz77_kernel_index;   // run blocks need no classification
+        } else {
+            kernels[i] = kernel_selection(classify_block(block), alpha);
+        }
+        MemoryReservation reservation(
+            budget, kernel_call_memory(kernels[i], KernelOperation::compress, block.size(), lz77));
+        flags[i] = compress_block(view, i, kernels[i], options, lz77, payloads[i]);
+    });
+
+    write_blocks(input, output, options, kernels, flags, payloads);
+    for (std::size_t i = 0; i < count; ++i) {
+        if (flags[i] & block_flag_run) {
+            kernels[i] = 0;
+        }
+    }
+    return kernels;
+}
+
+void compress_blocks(const std::string& input, std::string& output, int kernel_index,
+                     const AdaptiveOptions& options) {
+    get_codec_entry(kernel_index); // validates the index
+    if (options.cross_block_window && kernel_index != lz77_kernel_index) {
+        throw std::invalid_argument("cross_block_window requires the LZ77 kernel");
+    }
+    const std::size_t count = block_count(input, options);
+
+    std::vector<int> kernels(count, kernel_index);
+    std::vector<std::uint8_t> flags(count);
+    std::vector<std::string> payloads(count);
+    const Lz77Config lz77 = lz77_config_for_budget(options.memory_limit, options.threads, options.block_size);
+    MemoryBudget budget(options.memory_limit);
+    parallel_for(count, options.threads, [&](std::size_t i) {
+        const std::size_t raw_size = std::min(options.block_size, input.size() - i * options.block_size);
+        MemoryReservation reservation(
+            budget, kernel_call_memory(kernel_index, KernelOperation::compress, raw_size, lz77));
+        flags[i] = compress_block(input, i, kernel_index, options, lz77, payloads[i]);
+    });
+
+    write_blocks(input, output, options, kernels, flags, payloads);
+}
+
+std::vector<int> easy_compress_adaptive(const std::string& input_filepath, const std::string& output_filepath,
+                                        double alpha, const AdaptiveOptions& options) {
+    std::string output;
+    std::vector<int> kernels = compress_adaptive(read_file(input_filepath), output, alpha, options);
+    write_file(output_filepath, output);
+    return kernels;
+}
+
+} // namespace easy_compress_dlib
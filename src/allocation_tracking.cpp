@@ -0,0 +1,117 @@
+#include "../include/easy_compress_dlib/allocation_tracking.h"
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace easy_compress_dlib {
+
+namespace {
+
+// Plain thread_local with constant initialization, so operator new can use it
+// at any point of a thread's life
+constinit thread_local AllocationStats thread_stats{};
+
+} // namespace
+
+AllocationStats operator-(const AllocationStats& end, const AllocationStats& start) {
+    AllocationStats difference;
+    difference.allocations = end.allocations - start.allocations;
+    difference.deallocations = end.deallocations - start.deallocations;
+    difference.bytes = end.bytes - start.bytes;
+    return difference;
+}
+
+bool allocation_tracking_available() {
+#ifdef EASY_COMPRESS_DLIB_TRACK_ALLOCATIONS
+    return true;
+#else
+    return false;
+#endif
+}
+
+AllocationStats thread_allocation_stats() {
+    return thread_stats;
+}
+
+#ifdef EASY_COMPRESS_DLIB_TRACK_ALLOCATIONS
+
+namespace {
+
+void* counted_allocate(std::size_t size, std::size_t alignment) {
+    ++thread_stats.allocations;
+    thread_stats.bytes += size;
+    if (size == 0) {
+        size = 1;
+    }
+    void* p = nullptr;
+    if (alignment <= alignof(std::max_align_t)) {
+        p = std::malloc(size);
+    } else {
+        // aligned_alloc wants a multiple of the alignment
+        p = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+    }
+    return p;
+}
+
+void counted_free(void* p) {
+    if (p) {
+        ++thread_stats.deallocations;
+        std::free(p);
+    }
+}
+
+void* counted_allocate_or_throw(std::size_t size, std::size_t alignment) {
+    if (void* p = counted_allocate(size, alignment)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+} // namespace
+
+#endif
+
+} // namespace easy_compress_dlib
+
+#ifdef EASY_COMPRESS_DLIB_TRACK_ALLOCATIONS
+
+using easy_compress_dlib::counted_allocate;
+using easy_compress_dlib::counted_allocate_or_throw;
+using easy_compress_dlib::counted_free;
+
+void* operator new(std::size_t size) {
+    return counted_allocate_or_throw(size, alignof(std::max_align_t));
+}
+
+void* operator new[](std::size_t size) {
+    return counted_allocate_or_throw(size, alignof(std::max_align_t));
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    return counted_allocate_or_throw(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return counted_allocate_or_throw(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return counted_allocate(size, alignof(std::max_align_t));
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return counted_allocate(size, alignof(std::max_align_t));
+}
+
+void operator delete(void* p) noexcept { counted_free(p); }
+void operator delete[](void* p) noexcept { counted_free(p); }
+void operator delete(void* p, std::size_t) noexcept { counted_free(p); }
+void operator delete[](void* p, std::size_t) noexcept { counted_free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { counted_free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { counted_free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { counted_free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { counted_free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { counted_free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { counted_free(p); }
+
+#endif
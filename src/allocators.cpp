@@ -0,0 +1,141 @@
+#include "../include/easy_compress_dlib/allocators.h"
+#include <array>
+#include <bit>
+#include <cstdint>
+
+namespace easy_compress_dlib {
+
+MonotonicArena::MonotonicArena(std::size_t block_size)
+    : block_size_(block_size != 0 ? block_size : 1) {}
+
+MonotonicArena::~MonotonicArena() {
+    while (first_) {
+        Block* next = first_->next;
+        ::operator delete(first_);
+        first_ = next;
+    }
+}
+
+void* MonotonicArena::allocate(std::size_t bytes, std::size_t alignment) {
+    const auto address = reinterpret_cast<std::uintptr_t>(cursor_);
+    const std::size_t padding = (alignment - address % alignment) % alignment;
+    if (cursor_ && padding + bytes <= static_cast<std::size_t>(end_ - cursor_)) {
+        char* p = cursor_ + padding;
+        cursor_ = p + bytes;
+        in_use_ += padding + bytes;
+        return p;
+    }
+    return allocate_slow(bytes, alignment);
+}
+
+void* MonotonicArena::allocate_slow(std::size_t bytes, std::size_t alignment) {
+    // Worst case padding, as block data is only aligned to max_align_t
+    const std::size_t needed = bytes + (alignment > alignof(std::max_align_t) ? alignment : 0);
+    // Move on to the next kept block if it is big enough, else put a new one
+    // in front of it
+    Block* next = current_ ? current_->next : first_;
+    if (!next || next->size < needed) {
+        const std::size_t size = needed > block_size_ ? needed : block_size_;
+        Block* block = static_cast<Block*>(::operator new(sizeof(Block) + size));
+        block->next = next;
+        block->size = size;
+        reserved_ += size;
+        if (current_) {
+            current_->next = block;
+        } else {
+            first_ = block;
+        }
+        next = block;
+    }
+    // The rest of the current block is given up until the next release
+    if (current_) {
+        in_use_ += static_cast<std::size_t>(end_ - cursor_);
+    }
+    current_ = next;
+    cursor_ = block_data(current_);
+    end_ = cursor_ + current_->size;
+    return allocate(bytes, alignment);
+}
+
+void MonotonicArena::release() {
+    current_ = nullptr;
+    cursor_ = nullptr;
+    end_ = nullptr;
+    in_use_ = 0;
+}
+
+namespace {
+
+constexpr std::size_t pool_class_count = std::bit_width(pool_max_size) - std::bit_width(pool_min_size) + 1;
+
+struct FreeBlock {
+    FreeBlock* next;
+};
+
+std::size_t pool_class(std::size_t bytes) {
+    return bytes <= pool_min_size ? 0
+                                  : static_cast<std::size_t>(std::bit_width(bytes - 1)) -
+                                        (std::bit_width(pool_min_size) - 1);
+}
+
+std::size_t pool_class_size(std::size_t size_class) {
+    return pool_min_size << size_class;
+}
+
+struct ThreadPoolCache {
+    std::array<FreeBlock*, pool_class_count> free{};
+    std::array<std::size_t, pool_class_count> cached{};   // blocks on each list
+
+    ~ThreadPoolCache() {
+        for (FreeBlock* block : free) {
+            while (block) {
+                FreeBlock* next = block->next;
+                ::operator delete(block);
+                block = next;
+            }
+        }
+    }
+};
+
+ThreadPoolCache& pool_cache() {
+    thread_local ThreadPoolCache cache;
+    return cache;
+}
+
+} // namespace
+
+void* pool_allocate(std::size_t bytes) {
+    if (bytes > pool_max_size) {
+        return ::operator new(bytes);
+    }
+    const std::size_t size_class = pool_class(bytes);
+    ThreadPoolCache& cache = pool_cache();
+    if (FreeBlock* block = cache.free[size_class]) {
+        cache.free[size_class] = block->next;
+        --cache.cached[size_class];
+        return block;
+    }
+    return ::operator new(pool_class_size(size_class));
+}
+
+void pool_deallocate(void* p, std::size_t bytes) noexcept {
+    if (!p) {
+        return;
+    }
+    if (bytes > pool_max_size) {
+        ::operator delete(p);
+        return;
+    }
+    const std::size_t size_class = pool_class(bytes);
+    ThreadPoolCache& cache = pool_cache();
+    if ((cache.cached[size_class] + 1) * pool_class_size(size_class) > pool_cache_bytes) {
+        ::operator delete(p);
+        return;
+    }
+    auto* block = static_cast<FreeBlock*>(p);
+    block->next = cache.free[size_class];
+    cache.free[size_class] = block;
+    ++cache.cached[size_class];
+}
+
+} // namespace easy_compress_dlib
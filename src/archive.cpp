@@ -0,0 +1,449 @@
+#include "../include/easy_compress_dlib/archive.h"
+#include "../include/easy_compress_dlib/block_classifier.h"
+#include "../include/easy_compress_dlib/kernel_selection.h"
+#include "../include/easy_compress_dlib/memory_budget.h"
+#include "../include/easy_compress_dlib/run_detector.h"
+#include "../include/easy_compress_dlib/thread_pool.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+
+namespace easy_compress_dlib {
+
+namespace {
+
+namespace fs = std::filesystem;
+
+constexpr std::size_t archive_preamble = sizeof(archive_magic) + 1;
+
+struct SourceFile {
+    std::string path;         // relative, '/' separated
+    fs::path location;
+    std::uint64_t size = 0;
+    std::uint64_t raw_offset = 0;
+    std::string type;         // small files only
+};
+
+// A solid block of whole small files, or one block-sized piece of a large file
+struct PlannedBlock {
+    std::vector<std::size_t> files;
+    std::string type;
+    std::size_t file = 0;
+    std::uint64_t offset = 0;
+    std::size_t size = 0;
+};
+
+std::vector<SourceFile> scan_directory(const std::string& directory) {
+    if (!fs::is_directory(directory)) {
+        throw std::runtime_error("Not a directory: " + directory);
+    }
+    std::vector<SourceFile> files;
+    for (const auto& entry : fs::recursive_directory_iterator(directory)) {
+        if (entry.is_symlink() || !entry.is_regular_file()) {
+            continue;
+        }
+        SourceFile file;
+        file.path = entry.path().lexically_relative(directory).generic_string();
+        file.location = entry.path();
+        file.size = entry.file_size();
+        files.push_back(std::move(file));
+    }
+    std::sort(files.begin(), files.end(),
+              [](const SourceFile& a, const SourceFile& b) { return a.path < b.path; });
+    return files;
+}
+
+// Reads size bytes at offset into data
+void read_file_range(const fs::path& location, std::uint64_t offset, std::size_t size, char* data) {
+    std::ifstream file(location, std::ios::binary);
+    if (!file.is_open() || !file.seekg(static_cast<std::streamoff>(offset)) ||
+        !file.read(data, static_cast<std::streamsize>(size))) {
+        throw std::runtime_error("Failed to read file: " + location.string());
+    }
+}
+
+void append_archive_block(std::string& record, int kernel_index, std::string_view raw, const Lz77Config& lz77) {
+    if (is_single_run(raw)) {
+        append_run_block(record, static_cast<unsigned char>(raw[0]), raw.size());
+    } else if (kernel_index == lz77_kernel_index && lz77 != Lz77Config{}) {
+        std::string payload;
+        compress_lz77(raw, payload, lz77);
+        append_compressed_block(record, kernel_index, 0, raw.size(), payload);
+    } else {
+        append_block(record, kernel_index, raw);
+    }
+}
+
+// Entry paths come from the archive, so never let them escape the output directory
+fs::path checked_output_path(const fs::path& root, const std::string& path) {
+    const fs::path relative(path);
+    bool safe = !path.empty() && !relative.has_root_path();
+    for (const auto& part : relative) {
+        safe = safe && part != "..";
+    }
+    if (!safe) {
+        throw std::runtime_error("Unsafe path in archive: " + path);
+    }
+    return root / relative;
+}
+
+class ArchiveReader {
+public:
+    explicit ArchiveReader(const std::string& filepath) : filepath_(filepath) {
+        file_.open(filepath, std::ios::binary);
+        if (!file_.is_open()) {
+            throw std::runtime_error("Failed to open archive: " + filepath);
+        }
+        const std::uint64_t file_size = fs::file_size(filepath);
+        const std::string preamble = read(0, std::min<std::uint64_t>(file_size, archive_preamble));
+        if (file_size < archive_preamble + 8 ||
+            preamble.compare(0, sizeof(archive_magic), archive_magic, sizeof(archive_magic)) != 0) {
+            throw std::runtime_error("Not an archive: " + filepath);
+        }
+        if (static_cast<std::uint8_t>(preamble[4]) != archive_version) {
+            throw std::runtime_error("Unsupported archive version");
+        }
+        index_offset_ = get_u64(read(file_size - 8, 8).data());
+        if (index_offset_ < archive_preamble || index_offset_ > file_size - 8) {
+            throw std::runtime_error("Malformed archive index");
+        }
+        parse_index(read(index_offset_, file_size - 8 - index_offset_));
+    }
+
+    const std::vector<ArchiveEntry>& entries() const { return entries_; }
+    std::size_t block_count() const { return block_offsets_.size(); }
+    std::uint64_t block_raw_start(std::size_t b) const { return raw_starts_[b]; }
+    std::uint64_t block_raw_size(std::size_t b) const { return raw_starts_[b + 1] - raw_starts_[b]; }
+
+    // Index of the block holding raw_offset
+    std::size_t block_at(std::uint64_t raw_offset) const {
+        return static_cast<std::size_t>(std::upper_bound(raw_starts_.begin(), raw_starts_.end(), raw_offset) -
+                                        raw_starts_.begin()) - 1;
+    }
+
+    // Thread safe; only the file reads are serialized
+    std::string decode(std::size_t b) const {
+        const std::uint64_t offset = block_offsets_[b];
+        if (index_offset_ - offset < block_header_size) {
+            throw std::runtime_error("Truncated archive block");
+        }
+        const std::string header = read(offset, block_header_size);
+        BlockView block;
+        block.kernel_index = static_cast<unsigned char>(header[0]);
+        block.flags = static_cast<std::uint8_t>(header[1]);
+        block.raw_size = get_u32(header.data() + 2);
+        const std::uint32_t payload_size = get_u32(header.data() + 6);
+        if (index_offset_ - offset - block_header_size < payload_size || block.raw_size != block_raw_size(b) ||
+            (block.flags & block_flag_primed)) {
+            throw std::runtime_error("Malformed archive block");
+        }
+        const std::string payload = read(offset + block_header_size, payload_size);
+        block.payload = payload;
+        std::string raw;
+        decode_block(block, raw);
+        return raw;
+    }
+
+    std::string read_range(std::uint64_t raw_offset, std::uint64_t size) const {
+        std::string data;
+        data.reserve(size);
+        for (std::size_t b = block_at(raw_offset); data.size() < size; ++b) {
+            const std::string raw = decode(b);
+            const std::uint64_t begin = raw_offset + data.size() - raw_starts_[b];
+            data.append(raw, begin, std::min<std::uint64_t>(raw.size() - begin, size - data.size()));
+        }
+        return data;
+    }
+
+private:
+    std::string read(std::uint64_t offset, std::uint64_t size) const {
+        std::string data(size, '\0');
+        std::lock_guard<std::mutex> lock(mutex_);
+        file_.seekg(static_cast<std::streamoff>(offset));
+        if (!file_.read(data.data(), static_cast<std::streamsize>(size))) {
+            file_.clear();
+            throw std::runtime_error("Failed to read archive: " + filepath_);
+        }
+        return data;
+    }
+
+    void parse_index(std::string_view index) {
+        std::size_t pos = 0;
+        auto need = [&](std::size_t n) {
+            if (index.size() - pos < n) {
+                throw std::runtime_error("Malformed archive index");
+            }
+        };
+
+        need(4);
+        const std::uint32_t block_count = get_u32(index.data() + pos);
+        pos += 4;
+        need(std::uint64_t(block_count) * 12);
+        raw_starts_.assign(1, 0);
+        for (std::uint32_t b = 0; b < block_count; ++b) {
+            const std::uint64_t offset = get_u64(index.data() + pos);
+            if (offset < archive_preamble || offset >= index_offset_ ||
+                (!block_offsets_.empty() && offset <= block_offsets_.back())) {
+                throw std::runtime_error("Malformed archive index");
+            }
+            block_offsets_.push_back(offset);
+            raw_starts_.push_back(raw_starts_.back() + get_u32(index.data() + pos + 8));
+            pos += 12;
+        }
+
+        need(4);
+        const std::uint32_t entry_count = get_u32(index.data() + pos);
+        pos += 4;
+        for (std::uint32_t e = 0; e < entry_count; ++e) {
+            need(2);
+            const std::size_t path_size = static_cast<unsigned char>(index[pos]) |
+                                          static_cast<std::size_t>(static_cast<unsigned char>(index[pos + 1])) << 8;
+            pos += 2;
+            need(path_size + 16);
+            ArchiveEntry entry;
+            entry.path.assign(index.data() + pos, path_size);
+            entry.raw_offset = get_u64(index.data() + pos + path_size);
+            entry.size = get_u64(index.data() + pos + path_size + 8);
+            pos += path_size + 16;
+            if (entry.raw_offset > raw_starts_.back() || entry.size > raw_starts_.back() - entry.raw_offset ||
+                (!entries_.empty() && entry.path <= entries_.back().path)) {
+                throw std::runtime_error("Malformed archive index");
+            }
+            entries_.push_back(std::move(entry));
+        }
+        if (pos != index.size()) {
+            throw std::runtime_error("Malformed archive index");
+        }
+    }
+
+    std::string filepath_;
+    mutable std::mutex mutex_;
+    mutable std::ifstream file_;
+    std::uint64_t index_offset_ = 0;
+    std::vector<std::uint64_t> block_offsets_;
+    std::vector<std::uint64_t> raw_starts_;   // block_count + 1 entries
+    std::vector<ArchiveEntry> entries_;
+};
+
+} // namespace
+
+ArchiveReport create_archive(const std::string& directory, const std::string& archive_filepath, double alpha,
+                             const ArchiveOptions& options) {
+    if (options.block_size == 0 || options.solid_block_size == 0) {
+        throw std::invalid_argument("Block size must be non-zero");
+    }
+    // A solid block may hold a single file up to small_file_limit, and the
+    // index stores block sizes as u32
+    if (options.block_size > max_block_size || options.solid_block_size > max_block_size ||
+        options.small_file_limit > max_block_size) {
+        throw std::invalid_argument("Block size exceeds the archive's 32-bit size field");
+    }
+    std::vector<SourceFile> files = scan_directory(directory);
+    ThreadPool pool(options.threads);
+    MemoryBudget budget(options.memory_limit);
+
+    // Classify the small files. Their contents are dropped again and read
+    // once more by their solid block's task, so only the files being
+    // classified or compressed are held in memory.
+    {
+        TaskGroup group(pool);
+        for (auto& file : files) {
+            if (file.size != 0 && file.size <= options.small_file_limit) {
+                group.run([&file, &budget] {
+                    MemoryReservation reservation(budget, file.size);
+                    std::string contents(file.size, '\0');
+                    read_file_range(file.location, 0, file.size, contents.data());
+                    file.type = classify_block(contents);
+                });
+            }
+        }
+        group.wait();
+    }
+
+    // Small files of one type share solid blocks, in path order; large files
+    // follow, split into blocks
+    std::map<std::string, std::vector<std::size_t>> by_type;
+    for (std::size_t i = 0; i < files.size(); ++i) {
+        if (files[i].size != 0 && files[i].size <= options.small_file_limit) {
+            by_type[files[i].type].push_back(i);
+        }
+    }
+    std::vector<PlannedBlock> blocks;
+    std::uint64_t raw_offset = 0;
+    for (const auto& [type, members] : by_type) {
+        for (std::size_t i : members) {
+            if (blocks.empty() || blocks.back().type != type ||
+                blocks.back().size + files[i].size > options.solid_block_size) {
+                blocks.emplace_back();
+                blocks.back().type = type;
+            }
+            files[i].raw_offset = raw_offset;
+            blocks.back().files.push_back(i);
+            blocks.back().size += files[i].size;
+            raw_offset += files[i].size;
+        }
+    }
+    const std::size_t solid_blocks = blocks.size();
+    for (std::size_t i = 0; i < files.size(); ++i) {
+        if (files[i].size <= options.small_file_limit) {
+            if (files[i].size == 0) {
+                files[i].raw_offset = raw_offset;
+            }
+            continue;
+        }
+        files[i].raw_offset = raw_offset;
+        for (std::uint64_t offset = 0; offset < files[i].size; offset += options.block_size) {
+            PlannedBlock block;
+            block.file = i;
+            block.offset = offset;
+            block.size = static_cast<std::size_t>(std::min<std::uint64_t>(options.block_size, files[i].size - offset));
+            blocks.push_back(block);
+        }
+        raw_offset += files[i].size;
+    }
+
+    if (blocks.size() > UINT32_MAX || files.size() > UINT32_MAX) {
+        throw std::runtime_error("Too many blocks or files for archive");
+    }
+
+    // Every block is one task on the same pool, so one huge file and thousands
+    // of small ones keep all workers busy alike
+    std::vector<std::string> records(blocks.size());
+    const std::size_t largest_block = std::max({options.block_size, options.solid_block_size, options.small_file_limit});
+    const Lz77Config lz77 = lz77_config_for_budget(options.memory_limit, pool.size(), largest_block);
+    {
+        TaskGroup group(pool);
+        for (std::size_t b = 0; b < blocks.size(); ++b) {
+            group.run([&, b] {
+                const PlannedBlock& block = blocks[b];
+                std::string raw;
+                int kernel_index;
+                if (block.files.empty()) {
+                    raw.resize(block.size);
+                    read_file_range(files[block.file].location, block.offset, block.size, raw.data());
+                    kernel_index = kernel_selection(classify_block(raw), alpha);
+                } else {
+                    kernel_index = kernel_selection(block.type, alpha);
+                }
+                // A solid block's files are only read once memory is reserved
+                MemoryReservation reservation(
+                    budget, kernel_call_memory(kernel_index, KernelOperation::compress, block.size, lz77));
+                raw.resize(block.size);
+                std::size_t pos = 0;
+                for (std::size_t i : block.files) {
+                    read_file_range(files[i].location, 0, files[i].size, raw.data() + pos);
+                    pos += files[i].size;
+                }
+                append_archive_block(records[b], kernel_index, raw, lz77);
+            });
+        }
+        group.wait();
+    }
+
+    std::ofstream out(archive_filepath, std::ios::binary);
+    if (!out.is_open()) {
+        throw std::runtime_error("Failed to open file for writing: " + archive_filepath);
+    }
+    std::string index;
+    put_u32(index, static_cast<std::uint32_t>(blocks.size()));
+    std::uint64_t offset = archive_preamble;
+    out.write(archive_magic, sizeof(archive_magic));
+    out.put(static_cast<char>(archive_version));
+    for (std::size_t b = 0; b < blocks.size(); ++b) {
+        put_u64(index, offset);
+        put_u32(index, static_cast<std::uint32_t>(blocks[b].size));
+        out.write(records[b].data(), static_cast<std::streamsize>(records[b].size()));
+        offset += records[b].size();
+    }
+    put_u32(index, static_cast<std::uint32_t>(files.size()));
+    for (const auto& file : files) {
+        if (file.path.size() > 0xFFFF) {
+            throw std::runtime_error("Path too long for archive: " + file.path);
+        }
+        index.push_back(static_cast<char>(file.path.size() & 0xFF));
+        index.push_back(static_cast<char>(file.path.size() >> 8));
+        index += file.path;
+        put_u64(index, file.raw_offset);
+        put_u64(index, file.size);
+    }
+    put_u64(index, offset);
+    out.write(index.data(), static_cast<std::streamsize>(index.size()));
+    out.close();
+    if (!out) {
+        throw std::runtime_error("Failed to write archive: " + archive_filepath);
+    }
+
+    ArchiveReport report;
+    report.files = files.size();
+    report.solid_blocks = solid_blocks;
+    report.blocks = blocks.size();
+    report.raw_bytes = raw_offset;
+    return report;
+}
+
+std::vector<ArchiveEntry> list_archive(const std::string& archive_filepath) {
+    return ArchiveReader(archive_filepath).entries();
+}
+
+std::string extract_archive_file(const std::string& archive_filepath, const std::string& path) {
+    const ArchiveReader reader(archive_filepath);
+    const auto& entries = reader.entries();
+    auto it = std::lower_bound(entries.begin(), entries.end(), path,
+                               [](const ArchiveEntry& entry, const std::string& p) { return entry.path < p; });
+    if (it == entries.end() || it->path != path) {
+        throw std::out_of_range("No such file in archive: " + path);
+    }
+    return reader.read_range(it->raw_offset, it->size);
+}
+
+void extract_archive(const std::string& archive_filepath, const std::string& output_directory, unsigned threads) {
+    const ArchiveReader reader(archive_filepath);
+    const fs::path root(output_directory);
+
+    // Create every file at its final size, then let each block task write the
+    // pieces of the files it holds
+    std::vector<const ArchiveEntry*> by_offset;
+    for (const auto& entry : reader.entries()) {
+        const fs::path target = checked_output_path(root, entry.path);
+        fs::create_directories(target.parent_path());
+        std::ofstream(target, std::ios::binary);
+        fs::resize_file(target, entry.size);
+        if (entry.size != 0) {
+            by_offset.push_back(&entry);
+        }
+    }
+    std::sort(by_offset.begin(), by_offset.end(),
+              [](const ArchiveEntry* a, const ArchiveEntry* b) { return a->raw_offset < b->raw_offset; });
+
+    ThreadPool pool(threads);
+    TaskGroup group(pool);
+    for (std::size_t b = 0; b < reader.block_count(); ++b) {
+        group.run([&, b] {
+            const std::string raw = reader.decode(b);
+            const std::uint64_t start = reader.block_raw_start(b);
+            const std::uint64_t end = start + raw.size();
+            // First entry ending after this block starts
+            auto it = std::upper_bound(by_offset.begin(), by_offset.end(), start,
+                                       [](std::uint64_t offset, const ArchiveEntry* e) {
+                                           return offset < e->raw_offset + e->size;
+                                       });
+            for (; it != by_offset.end() && (*it)->raw_offset < end; ++it) {
+                const ArchiveEntry& entry = **it;
+                const std::uint64_t begin = std::max(start, entry.raw_offset);
+                const std::uint64_t stop = std::min(end, entry.raw_offset + entry.size);
+                std::fstream file(checked_output_path(root, entry.path), std::ios::in | std::ios::out | std::ios::binary);
+                file.seekp(static_cast<std::streamoff>(begin - entry.raw_offset));
+                file.write(raw.data() + (begin - start), static_cast<std::streamsize>(stop - begin));
+                if (!file) {
+                    throw std::runtime_error("Failed to write file: " + entry.path);
+                }
+            }
+        });
+    }
+    group.wait();
+}
+
+} // namespace easy_compress_dlib
@@ -0,0 +1,293 @@
+#include "../include/easy_compress_dlib/benchmark.h"
+#include "../include/easy_compress_dlib/kernel_metrics_table.h"
+#include "../include/easy_compress_dlib/lz77_buffer_kernel_1.h"
+#include "../include/easy_compress_dlib/lz77_buffer_kernel_2.h"
+#include "../include/easy_compress_dlib/lz77_buffer_kernel_c.h"
+#include "../include/easy_compress_dlib/sliding_buffer.h"
+#include "../include/easy_compress_dlib/synthetic_corpus.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <sys/resource.h>
+
+namespace easy_compress_dlib {
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+double seconds_since(clock_type::time_point start) {
+    return std::chrono::duration<double>(clock_type::now() - start).count();
+}
+
+void put_json_string(std::string& out, std::string_view value) {
+    out.push_back('"');
+    for (char c : value) {
+        switch (c) {
+            case '"':  out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char escaped[8];
+                    std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned char>(c));
+                    out += escaped;
+                } else {
+                    out.push_back(c);
+                }
+        }
+    }
+    out.push_back('"');
+}
+
+void put_json_number(std::string& out, double value) {
+    if (!std::isfinite(value)) {
+        out += "null";
+        return;
+    }
+    char number[32];
+    std::snprintf(number, sizeof(number), "%.9g", value);
+    out += number;
+}
+
+void put_json_samples(std::string& out, const std::vector<double>& samples) {
+    out.push_back('[');
+    for (std::size_t i = 0; i < samples.size(); ++i) {
+        if (i != 0) {
+            out.push_back(',');
+        }
+        put_json_number(out, samples[i]);
+    }
+    out.push_back(']');
+}
+
+// {"cycles": per byte, ..., "ipc": ...}, or null without hardware events
+void put_json_counters(std::string& out, const CounterReading& counters, std::size_t bytes) {
+    if (counters.available == 0 || bytes == 0) {
+        out += "null";
+        return;
+    }
+    out.push_back('{');
+    for (std::size_t e = 0; e < hardware_event_count; ++e) {
+        const auto event = static_cast<HardwareEvent>(e);
+        if (counters.has(event)) {
+            put_json_string(out, hardware_event_name(event));
+            out += ": ";
+            put_json_number(out, static_cast<double>(counters.get(event)) / bytes);
+            out += ", ";
+        }
+    }
+    out += "\"ipc\": ";
+    put_json_number(out, counters.ipc());
+    out.push_back('}');
+}
+
+double mb_per_second(std::size_t bytes, const std::vector<double>& seconds) {
+    const double median = percentile(seconds, 50);
+    return median > 0 ? bytes / 1e6 / median : 0.0;
+}
+
+} // namespace
+
+std::vector<BenchmarkSubject> kernel_subjects() {
+    std::vector<BenchmarkSubject> subjects;
+    for (int i = 1; i <= codec_count; ++i) {
+        const KernelEntry& entry = get_codec_entry(i);
+        subjects.push_back({entry.name, entry.compress, entry.decompress});
+    }
+    return subjects;
+}
+
+std::vector<BenchmarkSubject> lz77_buffer_subjects() {
+    using kernel_1 = dlib::lz77_buffer_kernel_1<sliding_buffer>;
+    using kernel_2 = dlib::lz77_buffer_kernel_2<sliding_buffer>;
+    constexpr std::size_t brute_force_limit = 1024 * 1024;
+    const decompress_function lz77_decompress = get_codec_entry(lz77_kernel_index).decompress;
+    return {
+        {"lz77_buffer_kernel_1", compress_lz77_with_buffer<kernel_1>, lz77_decompress, brute_force_limit},
+        {"lz77_buffer_kernel_2", compress_lz77_with_buffer<kernel_2>, lz77_decompress},
+        {"lz77_buffer_kernel_c<kernel_1>", compress_lz77_with_buffer<dlib::lz77_buffer_kernel_c<kernel_1>>,
+         lz77_decompress, brute_force_limit},
+        {"lz77_buffer_kernel_c<kernel_2>", compress_lz77_with_buffer<dlib::lz77_buffer_kernel_c<kernel_2>>,
+         lz77_decompress},
+    };
+}
+
+double BenchmarkResult::bits_per_byte() const {
+    return input_size ? 8.0 * compressed_size / input_size : 0.0;
+}
+
+double BenchmarkResult::compress_mb_per_second() const {
+    return mb_per_second(input_size, compress_seconds);
+}
+
+double BenchmarkResult::decompress_mb_per_second() const {
+    return mb_per_second(input_size, decompress_seconds);
+}
+
+double percentile(std::vector<double> samples, double p) {
+    if (samples.empty()) {
+        return 0.0;
+    }
+    std::sort(samples.begin(), samples.end());
+    const double rank = std::ceil(p / 100.0 * samples.size());
+    const std::size_t index = rank < 1 ? 0 : std::min(samples.size(), static_cast<std::size_t>(rank)) - 1;
+    return samples[index];
+}
+
+unsigned benchmark_repetitions(std::size_t input_size, const BenchmarkOptions& options) {
+    const std::uint64_t per_repetition = std::max<std::uint64_t>(1, input_size);
+    return static_cast<unsigned>(std::clamp<std::uint64_t>(options.max_bytes_per_case / per_repetition, 1,
+                                                           std::max(1u, options.repetitions)));
+}
+
+BenchmarkResult run_benchmark_case(const BenchmarkSubject& subject, std::string_view file_type,
+                                   const std::string& input, const BenchmarkOptions& options) {
+    BenchmarkResult result;
+    result.subject = subject.name;
+    result.file_type = file_type;
+    result.input_size = input.size();
+
+    const bool rss_reset = reset_peak_rss();
+    try {
+        std::string compressed;
+        std::string decompressed;
+        subject.compress(input, compressed);
+        subject.decompress(compressed, decompressed, input.size());
+        result.compressed_size = compressed.size();
+        result.round_trip = decompressed == input;
+
+        const unsigned repetitions = benchmark_repetitions(input.size(), options);
+        for (unsigned r = 0; r < repetitions; ++r) {
+            CounterReading before;
+            if (options.hardware_counters) {
+                before = read_thread_counters();
+            }
+            auto start = clock_type::now();
+            subject.compress(input, compressed);
+            result.compress_seconds.push_back(seconds_since(start));
+            if (options.hardware_counters) {
+                result.compress_counters += read_thread_counters() - before;
+                before = read_thread_counters();
+            }
+            start = clock_type::now();
+            subject.decompress(compressed, decompressed, input.size());
+            result.decompress_seconds.push_back(seconds_since(start));
+            if (options.hardware_counters) {
+                result.decompress_counters += read_thread_counters() - before;
+            }
+        }
+    } catch (const std::exception& e) {
+        result.round_trip = false;
+        result.error = e.what();
+    }
+    // Without a reset the peak may come from an earlier case
+    result.peak_rss_bytes = rss_reset ? peak_rss_bytes() : 0;
+    return result;
+}
+
+std::vector<BenchmarkResult> run_benchmarks(const std::vector<BenchmarkSubject>& subjects,
+                                            const BenchmarkOptions& options,
+                                            void (*progress)(const BenchmarkSubject&, std::string_view file_type,
+                                                             std::size_t size)) {
+    std::vector<std::string> file_types = options.file_types;
+    if (file_types.empty()) {
+        file_types.assign(known_file_types.begin(), known_file_types.end());
+    }
+
+    std::vector<BenchmarkResult> results;
+    for (std::size_t size : options.sizes) {
+        for (const auto& file_type : file_types) {
+            const std::string input = generate_corpus(file_type, size, options.seed);
+            for (const auto& subject : subjects) {
+                if (size > subject.max_input_size) {
+                    continue;
+                }
+                if (progress) {
+                    progress(subject, file_type, size);
+                }
+                results.push_back(run_benchmark_case(subject, file_type, input, options));
+            }
+        }
+    }
+    return results;
+}
+
+std::string benchmark_results_json(const std::vector<BenchmarkResult>& results, const BenchmarkOptions& options) {
+    std::string out = "{\n  \"schema\": \"easy_compress_dlib.benchmark.v1\",\n  \"seed\": ";
+    out += std::to_string(options.seed);
+    out += ",\n  \"repetitions\": ";
+    out += std::to_string(options.repetitions);
+    out += ",\n  \"results\": [";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const BenchmarkResult& r = results[i];
+        out += i == 0 ? "\n    {" : ",\n    {";
+        out += "\"subject\": ";
+        put_json_string(out, r.subject);
+        out += ", \"file_type\": ";
+        put_json_string(out, r.file_type);
+        out += ", \"input_size\": " + std::to_string(r.input_size);
+        out += ", \"compressed_size\": " + std::to_string(r.compressed_size);
+        out += ", \"bpb\": ";
+        put_json_number(out, r.bits_per_byte());
+        out += ", \"round_trip\": ";
+        out += r.round_trip ? "true" : "false";
+        if (!r.error.empty()) {
+            out += ", \"error\": ";
+            put_json_string(out, r.error);
+        }
+        out += ", \"compress_mb_per_s\": ";
+        put_json_number(out, r.compress_mb_per_second());
+        out += ", \"decompress_mb_per_s\": ";
+        put_json_number(out, r.decompress_mb_per_second());
+        out += ", \"compress_p50_ms\": ";
+        put_json_number(out, 1e3 * percentile(r.compress_seconds, 50));
+        out += ", \"compress_p99_ms\": ";
+        put_json_number(out, 1e3 * percentile(r.compress_seconds, 99));
+        out += ", \"decompress_p50_ms\": ";
+        put_json_number(out, 1e3 * percentile(r.decompress_seconds, 50));
+        out += ", \"decompress_p99_ms\": ";
+        put_json_number(out, 1e3 * percentile(r.decompress_seconds, 99));
+        out += ", \"peak_rss_bytes\": " + std::to_string(r.peak_rss_bytes);
+        if (options.hardware_counters) {
+            const std::size_t repeated = r.input_size * r.compress_seconds.size();
+            out += ", \"compress_per_byte\": ";
+            put_json_counters(out, r.compress_counters, repeated);
+            out += ", \"decompress_per_byte\": ";
+            put_json_counters(out, r.decompress_counters, repeated);
+        }
+        out += ", \"compress_seconds\": ";
+        put_json_samples(out, r.compress_seconds);
+        out += ", \"decompress_seconds\": ";
+        put_json_samples(out, r.decompress_seconds);
+        out += "}";
+    }
+    out += "\n  ]\n}\n";
+    return out;
+}
+
+std::uint64_t peak_rss_bytes() {
+    // VmHWM follows resets through clear_refs; ru_maxrss does not
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, 6, "VmHWM:") == 0) {
+            return std::stoull(line.substr(6)) * 1024;
+        }
+    }
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        return static_cast<std::uint64_t>(usage.ru_maxrss) * 1024;   // kilobytes on Linux
+    }
+    return 0;
+}
+
+bool reset_peak_rss() {
+    std::ofstream clear_refs("/proc/self/clear_refs");
+    return clear_refs.is_open() && (clear_refs << "5").flush().good();
+}
+
+} // namespace easy_compress_dlib
@@ -0,0 +1,97 @@
+#include "../include/easy_compress_dlib/block_classifier.h"
+#include <algorithm>
+
+namespace easy_compress_dlib {
+
+BlockFeatures compute_block_features(std::string_view block, std::size_t sample_limit) {
+    BlockFeatures features;
+    if (block.empty() || sample_limit == 0) {
+        return features;
+    }
+
+    // Sample contiguous runs rather than single bytes so line structure survives
+    const std::size_t run = 256;
+    const std::size_t runs = std::max<std::size_t>(1, std::min(block.size(), sample_limit) / run);
+    const std::size_t stride = block.size() / runs;
+
+    std::size_t zeros = 0, binary = 0, markup = 0, c_syntax = 0, parens = 0, upper = 0, calls = 0;
+    std::size_t lines = 0, troff_lines = 0;
+    for (std::size_t r = 0; r < runs; ++r) {
+        std::size_t begin = r * stride;
+        std::size_t end = std::min(block.size(), begin + run);
+        bool line_start = true;
+        for (std::size_t i = begin; i < end; ++i) {
+            unsigned char c = static_cast<unsigned char>(block[i]);
+            ++features.sampled;
+            if (c == 0) {
+                ++zeros;
+            }
+            if ((c < 0x20 && c != '\n' && c != '\r' && c != '\t') || c >= 0x80) {
+                ++binary;
+            }
+            if (c == 0xE8 || c == 0xE9) {
+                ++calls;
+            }
+            switch (c) {
+                case '<': case '>': ++markup; break;
+                case '{': case '}': case ';': case '#': ++c_syntax; break;
+                case '(': case ')': ++parens; break;
+                default: break;
+            }
+            if (c >= 'A' && c <= 'Z') {
+                ++upper;
+            }
+            if (line_start && c == '.') {
+                ++troff_lines;
+            }
+            line_start = (c == '\n');
+            if (line_start) {
+                ++lines;
+            }
+        }
+    }
+
+    const double n = static_cast<double>(features.sampled);
+    features.zero_fraction = zeros / n;
+    features.binary_fraction = binary / n;
+    features.markup_fraction = markup / n;
+    features.c_syntax_fraction = c_syntax / n;
+    features.paren_fraction = parens / n;
+    features.upper_fraction = upper / n;
+    features.call_opcode_fraction = calls / n;
+    features.troff_line_fraction = lines ? static_cast<double>(troff_lines) / lines : 0.0;
+    features.average_line_length = n / (lines + 1);
+    return features;
+}
+
+std::string classify_block(std::string_view block) {
+    const BlockFeatures f = compute_block_features(block);
+
+    if (f.binary_fraction > 0.3) {
+        if (f.zero_fraction > 0.6) {
+            return "fax";
+        }
+        if (f.call_opcode_fraction > 0.005) {
+            return "SPRC";
+        }
+        return "Excl";
+    }
+    if (f.markup_fraction > 0.02 && f.markup_fraction > f.c_syntax_fraction) {
+        return "html";
+    }
+    if (f.troff_line_fraction > 0.2) {
+        return "man";
+    }
+    if (f.c_syntax_fraction > 0.015) {
+        return "Csrc";
+    }
+    if (f.paren_fraction > 0.04) {
+        return "list";
+    }
+    if (f.average_line_length < 40) {
+        return f.upper_fraction > 0.08 ? "play" : "poem";
+    }
+    return "text";
+}
+
+} // namespace easy_compress_dlib
@@ -0,0 +1,195 @@
+#include "../include/easy_compress_dlib/block_stream.h"
+#include "../include/easy_compress_dlib/filters.h"
+#include "../include/easy_compress_dlib/kernel_table.h"
+#include "../include/easy_compress_dlib/lz77_codec.h"
+#include "../include/easy_compress_dlib/parallel.h"
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+namespace easy_compress_dlib {
+
+void begin_block_stream(std::string& out) {
+    out.append(block_stream_magic, sizeof(block_stream_magic));
+    out.push_back(static_cast<char>(block_stream_version));
+}
+
+void append_compressed_block(std::string& out, int kernel_index, std::uint8_t flags,
+                             std::size_t raw_size, std::string_view payload) {
+    if (!is_valid_codec_index(kernel_index)) {
+        throw std::out_of_range("Invalid kernel index: " + std::to_string(kernel_index));
+    }
+    if (raw_size > max_block_size || payload.size() > max_block_size) {
+        throw std::invalid_argument("Block too large for a 32-bit size field");
+    }
+    out.push_back(static_cast<char>(kernel_index));
+    out.push_back(static_cast<char>(flags));
+    put_u32(out, static_cast<std::uint32_t>(raw_size));
+    put_u32(out, static_cast<std::uint32_t>(payload.size()));
+    out.append(payload);
+}
+
+void append_block(std::string& out, int kernel_index, std::string_view raw) {
+    std::string payload;
+    compress_with_kernel(kernel_index, std::string(raw), payload);
+    append_compressed_block(out, kernel_index, 0, raw.size(), payload);
+}
+
+void append_run_block(std::string& out, unsigned char value, std::size_t raw_size) {
+    append_compressed_block(out, lz77_kernel_index, block_flag_run, raw_size,
+                            std::string_view(reinterpret_cast<const char*>(&value), 1));
+}
+
+void end_block_stream(std::string& out) {
+    out.push_back(0);
+}
+
+std::vector<BlockView> parse_block_stream(std::string_view stream) {
+    const std::size_t preamble = sizeof(block_stream_magic) + 1;
+    if (stream.size() < preamble || stream.substr(0, sizeof(block_stream_magic)) !=
+            std::string_view(block_stream_magic, sizeof(block_stream_magic))) {
+        throw std::runtime_error("Not a block stream");
+    }
+    if (static_cast<std::uint8_t>(stream[4]) != block_stream_version) {
+        throw std::runtime_error("Unsupported block stream version");
+    }
+
+    std::vector<BlockView> blocks;
+    std::size_t pos = preamble;
+    while (true) {
+        if (pos >= stream.size()) {
+            throw std::runtime_error("Truncated block stream");
+        }
+        int kernel_index = static_cast<unsigned char>(stream[pos]);
+        if (kernel_index == 0) {
+            break;
+        }
+        if (stream.size() - pos < block_header_size) {
+            throw std::runtime_error("Truncated block header");
+        }
+        BlockView block;
+        block.kernel_index = kernel_index;
+        block.flags = static_cast<std::uint8_t>(stream[pos + 1]);
+        block.raw_size = get_u32(stream.data() + pos + 2);
+        std::uint32_t payload_size = get_u32(stream.data() + pos + 6);
+        pos += block_header_size;
+        if (stream.size() - pos < payload_size) {
+            throw std::runtime_error("Truncated block payload");
+        }
+        block.payload = stream.substr(pos, payload_size);
+        pos += payload_size;
+        blocks.push_back(block);
+    }
+    return blocks;
+}
+
+void decode_block(const BlockView& block, std::string& output) {
+    decode_block(block, std::string_view(), output);
+}
+
+void decode_block(const BlockView& block, std::string_view history, std::string& output) {
+    std::string raw;
+    if (block.flags & block_flag_run) {
+        if (block.payload.size() != 1) {
+            throw std::runtime_error("Malformed run block");
+        }
+        raw.assign(block.raw_size, block.payload[0]);
+    } else {
+        std::string_view payload = block.payload;
+        FilterChain filters;
+        if (block.flags & block_flag_filtered) {
+            filters = read_filter_header(payload);
+        }
+        if (block.flags & block_flag_primed) {
+            if (block.kernel_index != lz77_kernel_index) {
+                throw std::runtime_error("Primed block for a kernel without history support");
+            }
+            decompress_lz77_primed(history, payload, raw, block.raw_size);
+        } else if (block.kernel_index == lz77_kernel_index) {
+            // Filters keep the size, so raw_size bounds the decoder
+            decompress_lz77(payload, raw, block.raw_size);
+        } else {
+            decompress_with_kernel(block.kernel_index, std::string(payload), raw, block.raw_size);
+        }
+        if (!filters.empty()) {
+            std::string filtered;
+            filtered.swap(raw);
+            invert_filters(filters, filtered, raw);
+        }
+    }
+    if (raw.size() != block.raw_size) {
+        throw std::runtime_error("Block size mismatch after decompression");
+    }
+    output.append(raw);
+}
+
+void decode_block_stream(std::string_view stream, std::string& output) {
+    std::size_t previous_start = output.size();
+    for (const auto& block : parse_block_stream(stream)) {
+        const std::size_t start = output.size();
+        decode_block(block, std::string_view(output).substr(previous_start), output);
+        previous_start = start;
+    }
+}
+
+void decode_block_stream(std::string_view stream, std::string& output, unsigned threads) {
+    const std::vector<BlockView> blocks = parse_block_stream(stream);
+
+    // A primed block needs the previous one, so work is split into runs that
+    // start at an unprimed block
+    std::vector<std::size_t> run_starts;
+    for (std::size_t i = 0; i < blocks.size(); ++i) {
+        if (i == 0 || !(blocks[i].flags & block_flag_primed)) {
+            run_starts.push_back(i);
+        }
+    }
+    run_starts.push_back(blocks.size());
+
+    // Every run decodes into a buffer of its own, so declared sizes are never
+    // allocated ahead of the data and output is untouched if a block fails
+    std::vector<std::string> runs(run_starts.size() - 1);
+    parallel_for(runs.size(), threads, [&](std::size_t run) {
+        std::string& raw = runs[run];
+        std::size_t previous_start = 0;
+        for (std::size_t i = run_starts[run]; i < run_starts[run + 1]; ++i) {
+            const std::size_t start = raw.size();
+            decode_block(blocks[i], std::string_view(raw).substr(previous_start), raw);
+            previous_start = start;
+        }
+    });
+
+    std::size_t total = 0;
+    for (const auto& raw : runs) {
+        total += raw.size();
+    }
+    output.reserve(output.size() + total);
+    for (auto& raw : runs) {
+        output.append(raw);
+        std::string().swap(raw);
+    }
+}
+
+std::string read_file(const std::string& filepath) {
+    std::ifstream file(filepath, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to open file: " + filepath);
+    }
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+void write_file(const std::string& filepath, std::string_view contents) {
+    std::ofstream file(filepath, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to open file for writing: " + filepath);
+    }
+    file.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+}
+
+void easy_decompress_blocks(const std::string& input_filepath, const std::string& output_filepath,
+                            unsigned threads) {
+    std::string output;
+    decode_block_stream(read_file(input_filepath), output, threads);
+    write_file(output_filepath, output);
+}
+
+} // namespace easy_compress_dlib
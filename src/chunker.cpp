@@ -0,0 +1,92 @@
+#include "../include/easy_compress_dlib/chunker.h"
+#include "../include/easy_compress_dlib/rolling_hash.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+
+namespace easy_compress_dlib {
+
+namespace {
+
+std::uint64_t mix64(std::uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+} // namespace
+
+std::size_t next_chunk_size(std::string_view data, const ChunkerOptions& options) {
+    if (options.min_size < gear_window || options.min_size >= options.avg_size ||
+        options.avg_size >= options.max_size) {
+        throw std::invalid_argument("Chunk sizes must satisfy 64 <= min_size < avg_size < max_size");
+    }
+    if (data.size() <= options.min_size) {
+        return data.size();
+    }
+
+    // A cut needs the top `bits` bits of the hash clear: 2 more bits than the
+    // average before avg_size, 2 fewer after it
+    const unsigned bits = static_cast<unsigned>(std::bit_width(options.avg_size) - 1);
+    const unsigned strict_shift = 64 - (bits + 2);
+    const unsigned loose_shift = 64 - (bits - 2);
+    const std::size_t limit = std::min(data.size(), options.max_size);
+    const std::size_t normal = std::min(limit, options.avg_size);
+
+    std::uint64_t hash = 0;
+    std::size_t i = options.min_size - gear_window;
+    for (; i < options.min_size; ++i) {
+        hash = gear_roll(hash, static_cast<unsigned char>(data[i]));
+    }
+    for (; i < normal; ++i) {
+        hash = gear_roll(hash, static_cast<unsigned char>(data[i]));
+        if ((hash >> strict_shift) == 0) {
+            return i + 1;
+        }
+    }
+    for (; i < limit; ++i) {
+        hash = gear_roll(hash, static_cast<unsigned char>(data[i]));
+        if ((hash >> loose_shift) == 0) {
+            return i + 1;
+        }
+    }
+    return limit;
+}
+
+std::vector<std::string_view> split_chunks(std::string_view data, const ChunkerOptions& options) {
+    std::vector<std::string_view> chunks;
+    chunks.reserve(data.size() / options.avg_size + 1);
+    while (!data.empty()) {
+        const std::size_t size = next_chunk_size(data, options);
+        chunks.push_back(data.substr(0, size));
+        data.remove_prefix(size);
+    }
+    return chunks;
+}
+
+ChunkFingerprint fingerprint_chunk(std::string_view data) {
+    // Two independent multiply-rotate lanes over 8-byte words, then a final
+    // avalanche that mixes in the length
+    std::uint64_t a = 0x243F6A8885A308D3ull;
+    std::uint64_t b = 0x13198A2E03707344ull;
+    std::size_t i = 0;
+    for (; i + 8 <= data.size(); i += 8) {
+        std::uint64_t word;
+        std::memcpy(&word, data.data() + i, sizeof(word));
+        a = std::rotl(a ^ (word * 0x9E3779B97F4A7C15ull), 31) * 0xC2B2AE3D27D4EB4Full;
+        b = std::rotl(b + (word ^ 0xA0761D6478BD642Full) * 0xE7037ED1A0B428DBull, 27) * 0x165667B19E3779F9ull;
+    }
+    std::uint64_t tail = 0;
+    std::memcpy(&tail, data.data() + i, data.size() - i);
+    a = std::rotl(a ^ (tail * 0x9E3779B97F4A7C15ull), 31) * 0xC2B2AE3D27D4EB4Full;
+    b = std::rotl(b + (tail ^ 0xA0761D6478BD642Full) * 0xE7037ED1A0B428DBull, 27) * 0x165667B19E3779F9ull;
+
+    const std::uint64_t length = data.size();
+    ChunkFingerprint fingerprint;
+    fingerprint.low = mix64(a ^ mix64(b + length));
+    fingerprint.high = mix64(b ^ mix64(a ^ (length << 1)));
+    return fingerprint;
+}
+
+} // namespace easy_compress_dlib
@@ -0,0 +1,73 @@
+#include "../include/easy_compress_dlib/compression_context.h"
+#include "../include/easy_compress_dlib/block_stream.h"
+#include "../include/easy_compress_dlib/hw_profiler.h"
+#include "../include/easy_compress_dlib/kernel_table.h"
+#include "../include/easy_compress_dlib/metrics.h"
+
+namespace easy_compress_dlib {
+
+CompressionContext::CompressionContext()
+    : kernel_(lz77_total_limit, lz77_lookahead_limit) {}
+
+void CompressionContext::compress(int codec_index, std::string_view input, std::string& output) {
+    const KernelEntry& entry = get_codec_entry(codec_index);
+    KernelCallTimer timer(codec_index, KernelOperation::compress, input.size());
+    ProfileScope scope(profile_region(codec_index, KernelOperation::compress), input.size());
+    if (codec_index == lz77_kernel_index) {
+        kernel_.clear();
+        output.clear();
+        lz77_encode(kernel_, input, output);
+    } else {
+        input_.assign(input);
+        entry.compress(input_, output);
+    }
+    timer.done(output.size());
+}
+
+void CompressionContext::decompress(int codec_index, std::string_view input, std::string& output,
+                                    std::size_t max_size) {
+    const KernelEntry& entry = get_codec_entry(codec_index);
+    KernelCallTimer timer(codec_index, KernelOperation::decompress, input.size());
+    ProfileScope scope(profile_region(codec_index, KernelOperation::decompress), input.size());
+    if (codec_index == lz77_kernel_index) {
+        output.clear();
+        lz77_decode(input, output, max_size);
+    } else {
+        input_.assign(input);
+        entry.decompress(input_, output, max_size);
+    }
+    timer.done(output.size());
+}
+
+void CompressionContext::compress_lz77_primed(std::string_view history, std::string_view input,
+                                              std::string& output) {
+    KernelCallTimer timer(lz77_kernel_index, KernelOperation::compress, input.size());
+    ProfileScope scope(profile_region(lz77_kernel_index, KernelOperation::compress), input.size());
+    kernel_.clear();
+    lz77_prime(kernel_, history);
+    output.clear();
+    lz77_encode(kernel_, input, output);
+    timer.done(output.size());
+}
+
+void CompressionContext::decompress_lz77_primed(std::string_view history, std::string_view input,
+                                                std::string& output, std::size_t max_size) {
+    KernelCallTimer timer(lz77_kernel_index, KernelOperation::decompress, input.size());
+    ProfileScope scope(profile_region(lz77_kernel_index, KernelOperation::decompress), input.size());
+    if (history.size() > lz77_history_limit) {
+        history.remove_prefix(history.size() - lz77_history_limit);
+    }
+    // history may view into output, so decode after a copy of it
+    scratch_.assign(history);
+    lz77_decode(input, scratch_, max_size);
+    output.assign(scratch_, history.size());
+    timer.done(output.size());
+}
+
+void append_block(std::string& out, int kernel_index, std::string_view raw, CompressionContext& context) {
+    std::string& payload = context.payload();
+    context.compress(kernel_index, raw, payload);
+    append_compressed_block(out, kernel_index, 0, raw.size(), payload);
+}
+
+} // namespace easy_compress_dlib
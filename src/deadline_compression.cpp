@@ -0,0 +1,135 @@
+#include "../include/easy_compress_dlib/deadline_compression.h"
+#include "../include/easy_compress_dlib/kernel_selection.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace easy_compress_dlib {
+
+using clock_type = std::chrono::steady_clock;
+
+KernelThroughputTable::KernelThroughputTable() {
+    for (int k = 1; k <= kernel_count; ++k) {
+        throughput_[k - 1].store(get_kernel_throughput(k), std::memory_order_relaxed);
+    }
+}
+
+double KernelThroughputTable::get(int kernel_index) const {
+    get_kernel_entry(kernel_index); // validates the index
+    return throughput_[kernel_index - 1].load(std::memory_order_relaxed);
+}
+
+void KernelThroughputTable::observe(int kernel_index, std::size_t bytes, std::chrono::nanoseconds elapsed) {
+    get_kernel_entry(kernel_index);
+    if (bytes == 0 || elapsed.count() <= 0) {
+        return;
+    }
+    double measured = bytes / std::chrono::duration<double>(elapsed).count();
+    // Exponential moving average so a single slow block does not dominate
+    auto& slot = throughput_[kernel_index - 1];
+    double current = slot.load(std::memory_order_relaxed);
+    slot.store(0.5 * current + 0.5 * measured, std::memory_order_relaxed);
+}
+
+void KernelThroughputTable::calibrate(const std::string& sample) {
+    if (sample.empty()) {
+        return;
+    }
+    std::string output;
+    for (int k = 1; k <= kernel_count; ++k) {
+        auto start = clock_type::now();
+        compress_with_kernel(k, sample, output);
+        auto elapsed = std::chrono::duration<double>(clock_type::now() - start).count();
+        if (elapsed > 0) {
+            throughput_[k - 1].store(sample.size() / elapsed, std::memory_order_relaxed);
+        }
+    }
+}
+
+KernelThroughputTable& default_throughput_table() {
+    static KernelThroughputTable table;
+    return table;
+}
+
+int select_kernel_for_deadline(const std::string& file_type, std::size_t input_size,
+                               std::chrono::nanoseconds budget, const KernelThroughputTable& table) {
+    const double budget_seconds = std::chrono::duration<double>(budget).count();
+
+    int best_kernel = 0;
+    double best_bpb = 0.0;
+    int fastest_kernel = 1;
+    for (int k = 1; k <= kernel_count; ++k) {
+        double bpb = get_kernel_bpb(k, file_type);
+        if (bpb < 0) {
+            throw std::invalid_argument("Unknown file type: " + file_type);
+        }
+        double throughput = table.get(k);
+        if (throughput > table.get(fastest_kernel)) {
+            fastest_kernel = k;
+        }
+        double expected_seconds = input_size / throughput;
+        if (expected_seconds <= budget_seconds && (best_kernel == 0 || bpb < best_bpb)) {
+            best_kernel = k;
+            best_bpb = bpb;
+        }
+    }
+    return best_kernel != 0 ? best_kernel : fastest_kernel;
+}
+
+DeadlineReport compress_with_deadline(const std::string& input, std::string& output,
+                                      const std::string& file_type, std::chrono::nanoseconds deadline,
+                                      const DeadlineOptions& options) {
+    if (options.block_size == 0) {
+        throw std::invalid_argument("Block size must be non-zero");
+    }
+    auto& table = default_throughput_table();
+    const auto start = clock_type::now();
+    auto plan_budget = [&](std::chrono::nanoseconds remaining) {
+        return std::chrono::nanoseconds(static_cast<long long>(remaining.count() * options.safety_factor));
+    };
+
+    DeadlineReport report;
+    int kernel = select_kernel_for_deadline(file_type, input.size(), plan_budget(deadline), table);
+    report.initial_kernel = kernel;
+
+    output.clear();
+    begin_block_stream(output);
+    std::string block;
+    for (std::size_t offset = 0; offset < input.size(); offset += options.block_size) {
+        block.assign(input, offset, options.block_size);
+
+        auto block_start = clock_type::now();
+        append_block(output, kernel, block);
+        table.observe(kernel, block.size(), clock_type::now() - block_start);
+
+        std::size_t remaining_bytes = input.size() - std::min(input.size(), offset + options.block_size);
+        if (remaining_bytes == 0) {
+            break;
+        }
+        // Re-plan only when the current kernel no longer fits the remaining time
+        auto remaining_time = deadline - std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now() - start);
+        double expected = remaining_bytes / table.get(kernel);
+        if (expected > std::chrono::duration<double>(plan_budget(remaining_time)).count()) {
+            int faster = select_kernel_for_deadline(file_type, remaining_bytes, plan_budget(remaining_time), table);
+            if (faster != kernel && table.get(faster) > table.get(kernel)) {
+                kernel = faster;
+                ++report.downgrades;
+            }
+        }
+    }
+    end_block_stream(output);
+
+    report.final_kernel = kernel;
+    report.elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now() - start);
+    return report;
+}
+
+int easy_compress_with_deadline(const std::string& input_filepath, const std::string& output_filepath,
+                                const std::string& file_type, std::chrono::milliseconds deadline,
+                                const DeadlineOptions& options) {
+    std::string output;
+    DeadlineReport report = compress_with_deadline(read_file(input_filepath), output, file_type, deadline, options);
+    write_file(output_filepath, output);
+    return report.initial_kernel;
+}
+
+} // namespace easy_compress_dlib
@@ -0,0 +1,295 @@
+#include "../include/easy_compress_dlib/dedup.h"
+#include "../include/easy_compress_dlib/block_classifier.h"
+#include "../include/easy_compress_dlib/block_stream.h"
+#include "../include/easy_compress_dlib/kernel_selection.h"
+#include "../include/easy_compress_dlib/kernel_table.h"
+#include "../include/easy_compress_dlib/parallel.h"
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+namespace easy_compress_dlib {
+
+namespace {
+
+constexpr std::size_t chunk_store_preamble = sizeof(chunk_store_magic) + 1;
+constexpr std::size_t dedup_container_preamble = sizeof(dedup_container_magic) + 1 + 8 + 4;
+
+void put_fingerprint(std::string& out, const ChunkFingerprint& fingerprint) {
+    put_u64(out, fingerprint.low);
+    put_u64(out, fingerprint.high);
+}
+
+ChunkFingerprint get_fingerprint(const char* p) {
+    return {get_u64(p), get_u64(p + 8)};
+}
+
+[[noreturn]] void throw_collision() {
+    throw std::runtime_error("Chunk fingerprint collision");
+}
+
+} // namespace
+
+ChunkStore::ChunkStore(const std::string& filename) : filename_(filename) {
+    if (!std::filesystem::exists(filename)) {
+        std::string preamble(chunk_store_magic, sizeof(chunk_store_magic));
+        preamble.push_back(static_cast<char>(chunk_store_version));
+        write_file(filename, preamble);
+    }
+    file_.open(filename, std::ios::in | std::ios::out | std::ios::binary);
+    if (!file_.is_open()) {
+        throw std::runtime_error("Failed to open chunk store: " + filename);
+    }
+
+    const std::uint64_t file_size = std::filesystem::file_size(filename);
+    char preamble[chunk_store_preamble];
+    if (file_size < chunk_store_preamble || !file_.read(preamble, sizeof(preamble)) ||
+        std::memcmp(preamble, chunk_store_magic, sizeof(chunk_store_magic)) != 0) {
+        throw std::runtime_error("Not a chunk store: " + filename);
+    }
+    if (static_cast<std::uint8_t>(preamble[4]) != chunk_store_version) {
+        throw std::runtime_error("Unsupported chunk store version");
+    }
+
+    // Rebuild the index from the record headers, skipping the payloads
+    std::uint64_t pos = chunk_store_preamble;
+    char header[chunk_record_header_size];
+    while (pos + chunk_record_header_size <= file_size) {
+        file_.seekg(static_cast<std::streamoff>(pos));
+        if (!file_.read(header, sizeof(header))) {
+            break;
+        }
+        Location location;
+        location.payload_offset = pos + chunk_record_header_size;
+        location.raw_size = get_u32(header + 16);
+        location.kernel_index = static_cast<unsigned char>(header[20]);
+        location.payload_size = get_u32(header + 21);
+        if (location.payload_offset + location.payload_size > file_size) {
+            break;
+        }
+        index_.emplace(get_fingerprint(header), location);
+        pos = location.payload_offset + location.payload_size;
+    }
+    end_ = pos;
+    if (end_ != file_size) {
+        file_.close();
+        std::filesystem::resize_file(filename, end_);
+        file_.open(filename, std::ios::in | std::ios::out | std::ios::binary);
+    }
+    file_.clear();
+}
+
+bool ChunkStore::contains(const ChunkFingerprint& fingerprint) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return index_.count(fingerprint) != 0;
+}
+
+bool ChunkStore::contains(const ChunkFingerprint& fingerprint, std::size_t raw_size) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(fingerprint);
+    if (it == index_.end()) {
+        return false;
+    }
+    if (it->second.raw_size != raw_size) {
+        throw_collision();
+    }
+    return true;
+}
+
+bool ChunkStore::matches(const ChunkFingerprint& fingerprint, std::string_view data) const {
+    return get(fingerprint) == data;
+}
+
+std::size_t ChunkStore::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return index_.size();
+}
+
+bool ChunkStore::put(const ChunkFingerprint& fingerprint, int kernel_index, std::size_t raw_size,
+                     std::string_view payload) {
+    if (!is_valid_codec_index(kernel_index)) {
+        throw std::out_of_range("Invalid kernel index: " + std::to_string(kernel_index));
+    }
+    std::string record;
+    record.reserve(chunk_record_header_size + payload.size());
+    put_fingerprint(record, fingerprint);
+    put_u32(record, static_cast<std::uint32_t>(raw_size));
+    record.push_back(static_cast<char>(kernel_index));
+    put_u32(record, static_cast<std::uint32_t>(payload.size()));
+    record.append(payload);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(fingerprint);
+    if (it != index_.end()) {
+        if (it->second.raw_size != raw_size) {
+            throw_collision();
+        }
+        return false;
+    }
+    file_.seekp(static_cast<std::streamoff>(end_));
+    file_.write(record.data(), static_cast<std::streamsize>(record.size()));
+    file_.flush();
+    if (!file_) {
+        file_.clear();
+        throw std::runtime_error("Failed to write chunk store: " + filename_);
+    }
+    index_.emplace(fingerprint, Location{end_ + chunk_record_header_size, static_cast<std::uint32_t>(payload.size()),
+                                         static_cast<std::uint32_t>(raw_size), kernel_index});
+    end_ += record.size();
+    return true;
+}
+
+std::string ChunkStore::get(const ChunkFingerprint& fingerprint) const {
+    Location location;
+    std::string payload;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = index_.find(fingerprint);
+        if (it == index_.end()) {
+            throw std::runtime_error("Chunk not found in store: " + filename_);
+        }
+        location = it->second;
+        payload.resize(location.payload_size);
+        file_.seekg(static_cast<std::streamoff>(location.payload_offset));
+        if (!file_.read(payload.data(), static_cast<std::streamsize>(payload.size()))) {
+            file_.clear();
+            throw std::runtime_error("Failed to read chunk store: " + filename_);
+        }
+    }
+    std::string raw;
+    decompress_with_kernel(location.kernel_index, payload, raw, location.raw_size);
+    if (raw.size() != location.raw_size) {
+        throw std::runtime_error("Chunk size mismatch after decompression");
+    }
+    return raw;
+}
+
+DedupReport compress_dedup(const std::string& input, std::string& output, ChunkStore& store, double alpha,
+                           const DedupOptions& options) {
+    const std::vector<std::string_view> chunks = split_chunks(input, options.chunker);
+    std::vector<ChunkFingerprint> fingerprints(chunks.size());
+    parallel_for(chunks.size(), options.threads, [&](std::size_t i) {
+        fingerprints[i] = fingerprint_chunk(chunks[i]);
+    });
+
+    // First occurrence of every chunk the store does not have yet. Repeats
+    // within the input are compared in memory, which is cheap.
+    std::vector<std::size_t> pending;
+    std::vector<std::size_t> stored;
+    std::unordered_map<ChunkFingerprint, std::size_t, ChunkFingerprintHash> first;
+    for (std::size_t i = 0; i < chunks.size(); ++i) {
+        auto [it, inserted] = first.emplace(fingerprints[i], i);
+        if (!inserted) {
+            if (chunks[it->second] != chunks[i]) {
+                throw_collision();
+            }
+        } else if (!store.contains(fingerprints[i], chunks[i].size())) {
+            pending.push_back(i);
+        } else if (options.verify_stored) {
+            stored.push_back(i);
+        }
+    }
+    parallel_for(stored.size(), options.threads, [&](std::size_t j) {
+        if (!store.matches(fingerprints[stored[j]], chunks[stored[j]])) {
+            throw_collision();
+        }
+    });
+
+    std::vector<int> kernels(pending.size());
+    std::vector<std::string> payloads(pending.size());
+    parallel_for(pending.size(), options.threads, [&](std::size_t j) {
+        const std::string_view chunk = chunks[pending[j]];
+        kernels[j] = kernel_selection(classify_block(chunk), alpha);
+        compress_with_kernel(kernels[j], std::string(chunk), payloads[j]);
+    });
+
+    DedupReport report;
+    report.chunks = chunks.size();
+    for (std::size_t j = 0; j < pending.size(); ++j) {
+        const std::string_view chunk = chunks[pending[j]];
+        if (store.put(fingerprints[pending[j]], kernels[j], chunk.size(), payloads[j])) {
+            report.new_chunks++;
+            report.new_bytes += chunk.size();
+        }
+    }
+
+    output.clear();
+    output.reserve(dedup_container_preamble + chunks.size() * dedup_reference_size);
+    output.append(dedup_container_magic, sizeof(dedup_container_magic));
+    output.push_back(static_cast<char>(dedup_container_version));
+    put_u64(output, input.size());
+    put_u32(output, static_cast<std::uint32_t>(chunks.size()));
+    for (std::size_t i = 0; i < chunks.size(); ++i) {
+        put_fingerprint(output, fingerprints[i]);
+        put_u32(output, static_cast<std::uint32_t>(chunks[i].size()));
+    }
+    return report;
+}
+
+void decompress_dedup(std::string_view container, const ChunkStore& store, std::string& output, unsigned threads) {
+    if (container.size() < dedup_container_preamble ||
+        container.substr(0, sizeof(dedup_container_magic)) !=
+            std::string_view(dedup_container_magic, sizeof(dedup_container_magic))) {
+        throw std::runtime_error("Not a dedup container");
+    }
+    if (static_cast<std::uint8_t>(container[4]) != dedup_container_version) {
+        throw std::runtime_error("Unsupported dedup container version");
+    }
+    const std::uint64_t total_size = get_u64(container.data() + 5);
+    const std::uint32_t chunk_count = get_u32(container.data() + 13);
+    if (container.size() - dedup_container_preamble != std::uint64_t(chunk_count) * dedup_reference_size) {
+        throw std::runtime_error("Truncated dedup container");
+    }
+
+    // Every reference must name a stored chunk of its size before the output
+    // grows, so the container's sizes cannot reserve memory the store does not back
+    std::vector<std::uint64_t> offsets(chunk_count + 1, 0);
+    const char* references = container.data() + dedup_container_preamble;
+    for (std::uint32_t i = 0; i < chunk_count; ++i) {
+        const char* reference = references + i * dedup_reference_size;
+        const std::uint32_t raw_size = get_u32(reference + 16);
+        if (!store.contains(get_fingerprint(reference), raw_size)) {
+            throw std::runtime_error("Chunk not found in store");
+        }
+        offsets[i + 1] = offsets[i] + raw_size;
+    }
+    if (offsets.back() != total_size) {
+        throw std::runtime_error("Dedup container size mismatch");
+    }
+
+    const std::size_t base = output.size();
+    output.resize(base + total_size);
+    try {
+        parallel_for(chunk_count, threads, [&](std::size_t i) {
+            std::string chunk = store.get(get_fingerprint(references + i * dedup_reference_size));
+            if (chunk.size() != offsets[i + 1] - offsets[i]) {
+                throw std::runtime_error("Chunk size mismatch");
+            }
+            std::memcpy(&output[base + offsets[i]], chunk.data(), chunk.size());
+        });
+    } catch (...) {
+        output.resize(base);
+        throw;
+    }
+}
+
+DedupReport easy_compress_dedup(const std::string& input_filepath, const std::string& output_filepath,
+                                const std::string& store_filepath, double alpha, const DedupOptions& options) {
+    ChunkStore store(store_filepath);
+    std::string output;
+    DedupReport report = compress_dedup(read_file(input_filepath), output, store, alpha, options);
+    write_file(output_filepath, output);
+    return report;
+}
+
+void easy_decompress_dedup(const std::string& input_filepath, const std::string& output_filepath,
+                           const std::string& store_filepath, unsigned threads) {
+    ChunkStore store(store_filepath);
+    std::string output;
+    decompress_dedup(read_file(input_filepath), store, output, threads);
+    write_file(output_filepath, output);
+}
+
+} // namespace easy_compress_dlib
@@ -0,0 +1,179 @@
+#include "../include/easy_compress_dlib/dictionary.h"
+#include "../include/easy_compress_dlib/block_stream.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <queue>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace easy_compress_dlib {
+
+namespace {
+
+constexpr std::size_t gram_size = 8;
+constexpr std::size_t message_headroom = 4 * 1024;   // window space left for the message itself
+
+std::uint64_t load_gram(const char* p) {
+    std::uint64_t gram;
+    std::memcpy(&gram, p, sizeof(gram));
+    return gram;
+}
+
+std::uint32_t content_hash(std::string_view content) {
+    std::uint32_t hash = 2166136261u;
+    for (char c : content) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+struct Segment {
+    std::size_t sample;
+    std::size_t offset;
+    std::size_t size;
+    std::uint64_t score;
+};
+
+} // namespace
+
+std::string train_dictionary(const std::vector<std::string>& samples, const DictionaryTrainingOptions& options) {
+    if (options.segment_size < gram_size) {
+        throw std::invalid_argument("Dictionary segment size must be at least 8");
+    }
+
+    // Number of samples each gram occurs in; grams seen in one sample only are not worth storing
+    std::unordered_map<std::uint64_t, std::uint32_t> frequency;
+    std::unordered_set<std::uint64_t> seen;
+    for (const auto& sample : samples) {
+        seen.clear();
+        for (std::size_t i = 0; i + gram_size <= sample.size(); ++i) {
+            if (seen.insert(load_gram(sample.data() + i)).second) {
+                ++frequency[load_gram(sample.data() + i)];
+            }
+        }
+    }
+
+    auto score = [&](const Segment& segment) {
+        std::uint64_t total = 0;
+        const char* data = samples[segment.sample].data() + segment.offset;
+        for (std::size_t i = 0; i + gram_size <= segment.size; ++i) {
+            auto it = frequency.find(load_gram(data + i));
+            if (it != frequency.end() && it->second > 1) {
+                total += it->second;
+            }
+        }
+        return total;
+    };
+
+    auto lower_score = [](const Segment& a, const Segment& b) { return a.score < b.score; };
+    std::priority_queue<Segment, std::vector<Segment>, decltype(lower_score)> candidates(lower_score);
+    for (std::size_t s = 0; s < samples.size(); ++s) {
+        for (std::size_t offset = 0; offset + gram_size <= samples[s].size(); offset += options.segment_size) {
+            Segment segment{s, offset, std::min(options.segment_size, samples[s].size() - offset), 0};
+            segment.score = score(segment);
+            if (segment.score != 0) {
+                candidates.push(segment);
+            }
+        }
+    }
+
+    // Greedy selection. Once a segment is taken its grams no longer count, so
+    // scores only go down and a popped segment is rescored before it is used.
+    std::vector<Segment> selected;
+    std::size_t selected_size = 0;
+    while (!candidates.empty() && selected_size < options.max_size) {
+        Segment segment = candidates.top();
+        candidates.pop();
+        segment.score = score(segment);
+        if (segment.score == 0) {
+            continue;
+        }
+        if (!candidates.empty() && segment.score < candidates.top().score) {
+            candidates.push(segment);
+            continue;
+        }
+        const char* data = samples[segment.sample].data() + segment.offset;
+        for (std::size_t i = 0; i + gram_size <= segment.size; ++i) {
+            frequency.erase(load_gram(data + i));
+        }
+        selected.push_back(segment);
+        selected_size += segment.size;
+    }
+
+    // Best segments last: they get the shortest match distances
+    std::string dictionary;
+    dictionary.reserve(selected_size);
+    for (auto it = selected.rbegin(); it != selected.rend(); ++it) {
+        dictionary.append(samples[it->sample], it->offset, it->size);
+    }
+    if (dictionary.size() > options.max_size) {
+        dictionary.erase(0, dictionary.size() - options.max_size);
+    }
+    return dictionary;
+}
+
+std::string train_dictionary_from_directory(const std::string& sample_dir, const DictionaryTrainingOptions& options) {
+    std::vector<std::string> samples;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(sample_dir)) {
+        if (entry.is_regular_file()) {
+            samples.push_back(read_file(entry.path().string()));
+        }
+    }
+    if (samples.empty()) {
+        throw std::runtime_error("No samples found in " + sample_dir);
+    }
+    return train_dictionary(samples, options);
+}
+
+Lz77Dictionary::Lz77Dictionary(std::string content)
+    : content_(std::move(content)), id_(content_hash(content_)), total_limit_(12) {
+    // Smallest window that holds the dictionary plus a small message, so a
+    // clone copies as little as possible
+    while (total_limit_ < 24 &&
+           (1ul << total_limit_) - lz77_lookahead_limit < content_.size() + message_headroom) {
+        ++total_limit_;
+    }
+    snapshot_ = std::make_unique<lz77_kernel>(total_limit_, lz77_lookahead_limit);
+    lz77_prime(*snapshot_, content_);
+}
+
+void Lz77Dictionary::compress(const std::string& input, std::string& output) const {
+    thread_local std::unique_ptr<lz77_kernel> kernel;
+    thread_local unsigned long kernel_total_limit = 0;
+    if (!kernel || kernel_total_limit != total_limit_) {
+        kernel = std::make_unique<lz77_kernel>(total_limit_, lz77_lookahead_limit);
+        kernel_total_limit = total_limit_;
+    }
+    kernel->copy_state_from(*snapshot_);
+    output.clear();
+    put_varint(output, input.size());
+    lz77_encode(*kernel, input, output);
+}
+
+void Lz77Dictionary::decompress(const std::string& input, std::string& output) const {
+    std::string_view tokens(input);
+    std::uint64_t raw_size = 0;
+    if (!get_varint(tokens, raw_size)) {
+        throw std::runtime_error("Truncated dictionary message");
+    }
+    // Matches may reach into the dictionary, so decode after it and drop it
+    output.assign(content_);
+    lz77_decode(tokens, output, static_cast<std::size_t>(std::min<std::uint64_t>(raw_size, lz77_unbounded)));
+    if (output.size() - content_.size() != raw_size) {
+        throw std::runtime_error("Dictionary message size mismatch");
+    }
+    output.erase(0, content_.size());
+}
+
+std::unique_ptr<Lz77Dictionary> Lz77Dictionary::load(const std::string& filename) {
+    return std::make_unique<Lz77Dictionary>(read_file(filename));
+}
+
+void Lz77Dictionary::save(const std::string& filename) const {
+    write_file(filename, content_);
+}
+
+} // namespace easy_compress_dlib
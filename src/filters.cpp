@@ -0,0 +1,294 @@
+#include "../include/easy_compress_dlib/filters.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <stdexcept>
+
+namespace easy_compress_dlib {
+
+namespace {
+
+constexpr std::size_t filter_sample_size = 64 * 1024;
+
+// Loops below are written over unsigned char pointers with no cross-iteration
+// dependency where the transform allows it, so the compiler can vectorize them
+using byte = unsigned char;
+
+const byte* bytes(std::string_view data) {
+    return reinterpret_cast<const byte*>(data.data());
+}
+
+byte* bytes(std::string& data) {
+    return reinterpret_cast<byte*>(data.data());
+}
+
+void delta_encode(std::string_view input, std::string& output, std::size_t distance) {
+    output.resize(input.size());
+    const byte* in = bytes(input);
+    byte* out = bytes(output);
+    const std::size_t head = std::min(distance, input.size());
+    std::copy(in, in + head, out);
+    for (std::size_t i = head; i < input.size(); ++i) {
+        out[i] = static_cast<byte>(in[i] - in[i - distance]);
+    }
+}
+
+void delta_decode(std::string_view input, std::string& output, std::size_t distance) {
+    output.resize(input.size());
+    const byte* in = bytes(input);
+    byte* out = bytes(output);
+    const std::size_t head = std::min(distance, input.size());
+    std::copy(in, in + head, out);
+    for (std::size_t i = head; i < input.size(); ++i) {
+        out[i] = static_cast<byte>(in[i] + out[i - distance]);
+    }
+}
+
+// Byte k of record r moves to k * records + r; a partial last record stays at the end
+void transpose(std::string_view input, std::string& output, std::size_t stride, bool inverse) {
+    output.resize(input.size());
+    const byte* in = bytes(input);
+    byte* out = bytes(output);
+    const std::size_t records = input.size() / stride;
+    for (std::size_t k = 0; k < stride; ++k) {
+        const std::size_t column = k * records;
+        if (inverse) {
+            for (std::size_t r = 0; r < records; ++r) {
+                out[r * stride + k] = in[column + r];
+            }
+        } else {
+            for (std::size_t r = 0; r < records; ++r) {
+                out[column + r] = in[r * stride + k];
+            }
+        }
+    }
+    const std::size_t tail = records * stride;
+    std::copy(in + tail, in + input.size(), out + tail);
+}
+
+// A call or jump whose 32-bit displacement lies within +-16 MB (high byte 00
+// or FF) has it replaced by the target relative to the block start, modulo
+// 2^25 and sign-extended so the high byte stays 00 or FF. Every E8/E9 consumes
+// its 4 operand bytes whether converted or not, so no byte a decision was based
+// on is changed later and both directions decide the same way.
+void x86_bcj(std::string_view input, std::string& output, bool encode) {
+    output.assign(input);
+    byte* p = bytes(output);
+    const std::size_t size = output.size();
+    for (std::size_t i = 0; i + 5 <= size;) {
+        if (p[i] != 0xE8 && p[i] != 0xE9) {
+            ++i;
+            continue;
+        }
+        if (p[i + 4] == 0x00 || p[i + 4] == 0xFF) {
+            std::uint32_t value = static_cast<std::uint32_t>(p[i + 1]) | static_cast<std::uint32_t>(p[i + 2]) << 8 |
+                                  static_cast<std::uint32_t>(p[i + 3]) << 16 | static_cast<std::uint32_t>(p[i + 4]) << 24;
+            const std::uint32_t position = static_cast<std::uint32_t>(i + 5);
+            value = encode ? value + position : value - position;
+            value &= 0x1FFFFFF;
+            if (value & 0x1000000) {
+                value |= 0xFE000000;
+            }
+            for (int b = 0; b < 4; ++b) {
+                p[i + 1 + b] = static_cast<byte>(value >> (8 * b));
+            }
+        }
+        i += 5;
+    }
+}
+
+void check_step(const FilterStep& step) {
+    switch (step.id) {
+        case FilterId::delta:
+        case FilterId::transpose:
+            if (step.parameter == 0) {
+                throw std::invalid_argument("Filter distance or stride must be non-zero");
+            }
+            return;
+        case FilterId::x86_bcj:
+            return;
+    }
+    throw std::invalid_argument("Unknown filter");
+}
+
+double order0_entropy(std::string_view data) {
+    if (data.empty()) {
+        return 0.0;
+    }
+    std::array<std::size_t, 256> counts{};
+    for (byte b : data) {
+        counts[b]++;
+    }
+    double bits = 0.0;
+    for (std::size_t count : counts) {
+        if (count != 0) {
+            double p = static_cast<double>(count) / data.size();
+            bits -= p * std::log2(p);
+        }
+    }
+    return bits;
+}
+
+bool looks_like_x86(std::string_view sample) {
+    const byte* p = bytes(sample);
+    std::size_t calls = 0;
+    std::size_t binary = 0;
+    for (std::size_t i = 0; i < sample.size(); ++i) {
+        if (p[i] >= 0x80 || (p[i] < 0x20 && p[i] != '\n' && p[i] != '\r' && p[i] != '\t')) {
+            binary++;
+        }
+        if (i + 5 <= sample.size() && (p[i] == 0xE8 || p[i] == 0xE9) && (p[i + 4] == 0x00 || p[i + 4] == 0xFF)) {
+            calls++;
+        }
+    }
+    // Compiled x86 has a call or jump every 100-200 bytes
+    return binary * 4 > sample.size() && calls * 256 > sample.size();
+}
+
+} // namespace
+
+void apply_filter(const FilterStep& step, std::string_view input, std::string& output) {
+    check_step(step);
+    switch (step.id) {
+        case FilterId::delta:     delta_encode(input, output, step.parameter); break;
+        case FilterId::transpose: transpose(input, output, step.parameter, false); break;
+        case FilterId::x86_bcj:   x86_bcj(input, output, true); break;
+    }
+}
+
+void invert_filter(const FilterStep& step, std::string_view input, std::string& output) {
+    check_step(step);
+    switch (step.id) {
+        case FilterId::delta:     delta_decode(input, output, step.parameter); break;
+        case FilterId::transpose: transpose(input, output, step.parameter, true); break;
+        case FilterId::x86_bcj:   x86_bcj(input, output, false); break;
+    }
+}
+
+void apply_filters(const FilterChain& chain, std::string_view input, std::string& output) {
+    if (chain.empty()) {
+        output.assign(input);
+        return;
+    }
+    std::string scratch;
+    std::string_view current = input;
+    for (std::size_t i = 0; i < chain.size(); ++i) {
+        // Write so that the last step lands in output
+        std::string& target = (chain.size() - i) % 2 == 1 ? output : scratch;
+        apply_filter(chain[i], current, target);
+        current = target;
+    }
+}
+
+void invert_filters(const FilterChain& chain, std::string_view input, std::string& output) {
+    if (chain.empty()) {
+        output.assign(input);
+        return;
+    }
+    std::string scratch;
+    std::string_view current = input;
+    for (std::size_t i = chain.size(); i-- > 0;) {
+        std::string& target = i % 2 == 0 ? output : scratch;
+        invert_filter(chain[i], current, target);
+        current = target;
+    }
+}
+
+void put_filter_header(std::string& out, const FilterChain& chain) {
+    if (chain.size() > max_filter_steps) {
+        throw std::invalid_argument("Too many filter steps");
+    }
+    out.push_back(static_cast<char>(chain.size()));
+    for (const auto& step : chain) {
+        check_step(step);
+        out.push_back(static_cast<char>(step.id));
+        out.push_back(static_cast<char>(step.parameter));
+    }
+}
+
+FilterChain read_filter_header(std::string_view& payload) {
+    if (payload.empty()) {
+        throw std::runtime_error("Truncated filter header");
+    }
+    const std::size_t count = static_cast<byte>(payload[0]);
+    if (count > max_filter_steps || payload.size() < 1 + 2 * count) {
+        throw std::runtime_error("Malformed filter header");
+    }
+    FilterChain chain;
+    for (std::size_t i = 0; i < count; ++i) {
+        FilterStep step{static_cast<FilterId>(payload[1 + 2 * i]), static_cast<std::uint8_t>(payload[2 + 2 * i])};
+        try {
+            check_step(step);
+        } catch (const std::invalid_argument& e) {
+            throw std::runtime_error(std::string("Malformed filter header: ") + e.what());
+        }
+        chain.push_back(step);
+    }
+    payload.remove_prefix(1 + 2 * count);
+    return chain;
+}
+
+std::size_t detect_record_stride(std::string_view data, std::size_t max_stride) {
+    data = data.substr(0, filter_sample_size);
+    max_stride = std::min(max_stride, max_record_stride);
+    if (data.size() < 8 * max_stride) {
+        return 1;
+    }
+    const byte* p = bytes(data);
+    std::array<std::size_t, max_record_stride + 1> matches{};
+    for (std::size_t s = 1; s <= max_stride; ++s) {
+        std::size_t count = 0;
+        for (std::size_t i = max_stride; i < data.size(); ++i) {
+            count += p[i] == p[i - s];
+        }
+        matches[s] = count;
+    }
+
+    std::size_t best = 2;
+    for (std::size_t s = 3; s <= max_stride; ++s) {
+        if (matches[s] > matches[best]) {
+            best = s;
+        }
+    }
+    // Multiples of the record length correlate about as well; keep the smallest
+    for (std::size_t s = 2; s < best; ++s) {
+        if (best % s == 0 && matches[s] * 10 >= matches[best] * 9) {
+            best = s;
+            break;
+        }
+    }
+    const std::size_t compared = data.size() - max_stride;
+    const bool strong = matches[best] * 10 >= compared * 2;
+    const bool beats_neighbours = matches[best] * 2 >= matches[1] * 3;
+    return strong && beats_neighbours ? best : 1;
+}
+
+FilterChain choose_filters(std::string_view data) {
+    const std::string_view sample = data.substr(0, filter_sample_size);
+    if (sample.size() < 256) {
+        return {};
+    }
+    if (looks_like_x86(sample)) {
+        return {{FilterId::x86_bcj, 0}};
+    }
+
+    FilterChain chain;
+    std::string current(sample);
+    const std::size_t stride = detect_record_stride(sample);
+    if (stride > 1) {
+        chain.push_back({FilterId::transpose, static_cast<std::uint8_t>(stride)});
+        std::string transposed;
+        apply_filter(chain.back(), current, transposed);
+        current.swap(transposed);
+    }
+
+    // Delta pays off when it removes at least half a bit per byte
+    std::string delta;
+    apply_filter({FilterId::delta, 1}, current, delta);
+    if (order0_entropy(delta) + 0.5 < order0_entropy(current)) {
+        chain.push_back({FilterId::delta, 1});
+    }
+    return chain;
+}
+
+} // namespace easy_compress_dlib
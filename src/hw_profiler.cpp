@@ -0,0 +1,275 @@
+#include "../include/easy_compress_dlib/hw_profiler.h"
+#include <cstdio>
+#include <mutex>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace easy_compress_dlib {
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+double now_seconds() {
+    return std::chrono::duration<double>(clock_type::now().time_since_epoch()).count();
+}
+
+#ifdef __linux__
+
+struct EventConfig {
+    std::uint32_t type;
+    std::uint64_t config;
+};
+
+// Same order as HardwareEvent
+constexpr EventConfig event_configs[hardware_event_count] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+};
+
+int open_event(const EventConfig& event, int group_fd) {
+    perf_event_attr attr{};
+    attr.size = sizeof(attr);
+    attr.type = event.type;
+    attr.config = event.config;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0));
+}
+
+// One group per thread; perf_event_open with pid 0 counts the calling thread
+class ThreadCounterGroup {
+public:
+    ThreadCounterGroup() {
+        for (std::size_t e = 0; e < hardware_event_count; ++e) {
+            const int fd = open_event(event_configs[e], leader_);
+            if (fd < 0) {
+                continue;
+            }
+            if (leader_ < 0) {
+                leader_ = fd;
+            }
+            fds_.push_back(fd);
+            slots_[fds_.size() - 1] = e;
+            available_ |= 1u << e;
+        }
+    }
+
+    ~ThreadCounterGroup() {
+        for (int fd : fds_) {
+            close(fd);
+        }
+    }
+
+    ThreadCounterGroup(const ThreadCounterGroup&) = delete;
+    ThreadCounterGroup& operator=(const ThreadCounterGroup&) = delete;
+
+    void read(CounterReading& reading) const {
+        if (leader_ < 0) {
+            return;
+        }
+        // nr, time_enabled, time_running, one value per event
+        std::uint64_t values[3 + hardware_event_count];
+        const ssize_t size = ::read(leader_, values, sizeof(values));
+        if (size < static_cast<ssize_t>(3 * sizeof(std::uint64_t)) || values[0] != fds_.size()) {
+            return;
+        }
+        // Scale up if the group shared the PMU with other groups
+        const double scale = values[2] != 0 && values[2] < values[1]
+                                 ? static_cast<double>(values[1]) / values[2] : 1.0;
+        for (std::size_t i = 0; i < fds_.size(); ++i) {
+            reading.events[slots_[i]] = static_cast<std::uint64_t>(values[3 + i] * scale);
+        }
+        reading.available = available_;
+    }
+
+private:
+    int leader_ = -1;
+    std::vector<int> fds_;
+    std::array<std::size_t, hardware_event_count> slots_{};   // event of each fd
+    std::uint32_t available_ = 0;
+};
+
+const ThreadCounterGroup& thread_group() {
+    thread_local ThreadCounterGroup group;
+    return group;
+}
+
+#endif
+
+struct ProfileTable {
+    std::mutex mutex;
+    std::array<RegionProfile, profile_region_count> regions;
+};
+
+ProfileTable& profile_table() {
+    static ProfileTable table;
+    return table;
+}
+
+std::string format_cost(bool available, double value, const char* format) {
+    if (!available) {
+        return "-";
+    }
+    char text[32];
+    std::snprintf(text, sizeof(text), format, value);
+    return text;
+}
+
+} // namespace
+
+const char* hardware_event_name(HardwareEvent event) {
+    switch (event) {
+        case HardwareEvent::cycles:           return "cycles";
+        case HardwareEvent::instructions:     return "instructions";
+        case HardwareEvent::cache_references: return "cache_references";
+        case HardwareEvent::cache_misses:     return "cache_misses";
+        case HardwareEvent::branches:         return "branches";
+        case HardwareEvent::branch_misses:    return "branch_misses";
+    }
+    return "unknown";
+}
+
+double CounterReading::ipc() const {
+    if (!has(HardwareEvent::cycles) || !has(HardwareEvent::instructions) || get(HardwareEvent::cycles) == 0) {
+        return 0.0;
+    }
+    return static_cast<double>(get(HardwareEvent::instructions)) / get(HardwareEvent::cycles);
+}
+
+CounterReading& CounterReading::operator+=(const CounterReading& other) {
+    // An empty reading takes on the other's events
+    available = seconds == 0.0 && available == 0 ? other.available : available & other.available;
+    seconds += other.seconds;
+    for (std::size_t e = 0; e < hardware_event_count; ++e) {
+        events[e] = available & (1u << e) ? events[e] + other.events[e] : 0;
+    }
+    return *this;
+}
+
+CounterReading read_thread_counters() {
+    CounterReading reading;
+#ifdef __linux__
+    thread_group().read(reading);
+#endif
+    reading.seconds = now_seconds();
+    return reading;
+}
+
+CounterReading operator-(const CounterReading& end, const CounterReading& start) {
+    CounterReading difference;
+    difference.seconds = end.seconds - start.seconds;
+    difference.available = end.available & start.available;
+    for (std::size_t e = 0; e < hardware_event_count; ++e) {
+        // Scaled counts of a multiplexed group can step back slightly
+        if (difference.available & (1u << e) && end.events[e] > start.events[e]) {
+            difference.events[e] = end.events[e] - start.events[e];
+        }
+    }
+    return difference;
+}
+
+bool hardware_counters_available() {
+    return read_thread_counters().available != 0;
+}
+
+std::string profile_region_name(std::size_t region) {
+    switch (region) {
+        case 0: return "lz77_parse";
+        case 1: return "find_match";
+        case 2: return "shift_buffer";
+    }
+    if (region >= profile_region_count) {
+        return "unknown";
+    }
+    const std::size_t kernel = region - fixed_profile_regions;
+    const auto operation = static_cast<KernelOperation>(kernel % kernel_operation_count);
+    return std::string(kernel_operation_name(operation)) + "_kernel_" +
+           get_codec_entry(static_cast<int>(kernel / kernel_operation_count) + 1).name;
+}
+
+double RegionProfile::per_byte(HardwareEvent event) const {
+    return bytes != 0 && counters.has(event) ? static_cast<double>(counters.get(event)) / bytes : 0.0;
+}
+
+double RegionProfile::nanoseconds_per_byte() const {
+    return bytes != 0 ? 1e9 * counters.seconds / bytes : 0.0;
+}
+
+void set_profiling(bool enabled) {
+    profile_detail::profiling.store(enabled, std::memory_order_relaxed);
+}
+
+namespace profile_detail {
+
+void add_sample(std::size_t region, std::uint64_t bytes, const CounterReading& start) {
+    const CounterReading sample = read_thread_counters() - start;
+    if (region >= profile_region_count) {
+        return;
+    }
+    ProfileTable& table = profile_table();
+    std::lock_guard<std::mutex> lock(table.mutex);
+    RegionProfile& profile = table.regions[region];
+    ++profile.calls;
+    profile.bytes += bytes;
+    profile.counters += sample;
+}
+
+} // namespace profile_detail
+
+std::vector<RegionProfile> collect_profile() {
+    ProfileTable& table = profile_table();
+    std::lock_guard<std::mutex> lock(table.mutex);
+    std::vector<RegionProfile> profile;
+    for (std::size_t region = 0; region < profile_region_count; ++region) {
+        if (table.regions[region].calls != 0) {
+            profile.push_back(table.regions[region]);
+            profile.back().name = profile_region_name(region);
+        }
+    }
+    return profile;
+}
+
+void reset_profile() {
+    ProfileTable& table = profile_table();
+    std::lock_guard<std::mutex> lock(table.mutex);
+    table.regions = {};
+}
+
+std::string profile_report(const std::vector<RegionProfile>& profile) {
+    std::string out;
+    char line[256];
+    std::snprintf(line, sizeof(line), "%-24s %10s %12s %9s %9s %6s %12s %12s\n", "region", "calls", "bytes",
+                  "ns/B", "cycles/B", "IPC", "cmiss/KB", "bmiss/KB");
+    out += line;
+    for (const RegionProfile& region : profile) {
+        const CounterReading& c = region.counters;
+        const bool bytes = region.bytes != 0;
+        std::snprintf(line, sizeof(line), "%-24s %10llu %12llu %9s %9s %6s %12s %12s\n", region.name.c_str(),
+                      static_cast<unsigned long long>(region.calls), static_cast<unsigned long long>(region.bytes),
+                      format_cost(bytes, region.nanoseconds_per_byte(), "%.3f").c_str(),
+                      format_cost(bytes && c.has(HardwareEvent::cycles),
+                                  region.per_byte(HardwareEvent::cycles), "%.3f").c_str(),
+                      format_cost(c.ipc() != 0.0, c.ipc(), "%.2f").c_str(),
+                      format_cost(bytes && c.has(HardwareEvent::cache_misses),
+                                  1024 * region.per_byte(HardwareEvent::cache_misses), "%.2f").c_str(),
+                      format_cost(bytes && c.has(HardwareEvent::branch_misses),
+                                  1024 * region.per_byte(HardwareEvent::branch_misses), "%.2f").c_str());
+        out += line;
+    }
+    if (!profile.empty() && profile.front().counters.available == 0) {
+        out += "hardware counters unavailable, wall-clock time only\n";
+    }
+    return out;
+}
+
+} // namespace easy_compress_dlib
@@ -0,0 +1,84 @@
+#include "../include/easy_compress_dlib/kernel_table.h"
+#include "../include/easy_compress_dlib/compression.h"
+#include "../include/easy_compress_dlib/hw_profiler.h"
+#include "../include/easy_compress_dlib/lz77_codec.h"
+#include "../include/easy_compress_dlib/metrics.h"
+#include <array>
+#include <stdexcept>
+
+namespace easy_compress_dlib {
+
+namespace {
+
+// The dlib compress_stream formats end with their own end of data marker
+template <kernel_function Decompress>
+void decompress_checked(const std::string& input, std::string& output, std::size_t max_size) {
+    Decompress(input, output);
+    if (output.size() > max_size) {
+        throw std::runtime_error("Decompressed data exceeds the expected size");
+    }
+}
+
+void decompress_lz77_tokens(const std::string& input, std::string& output, std::size_t max_size) {
+    output.clear();
+    lz77_decode(input, output, max_size);
+}
+
+} // namespace
+
+// Same order as the kernel_*_metrics tables, then the codecs without metrics
+const std::array<KernelEntry, codec_count> kernel_entries = {{
+    {"1a",  compress_kernel_1a,  decompress_checked<decompress_kernel_1a>},
+    {"1b",  compress_kernel_1b,  decompress_checked<decompress_kernel_1b>},
+    {"1c",  compress_kernel_1c,  decompress_checked<decompress_kernel_1c>},
+    {"1da", compress_kernel_1da, decompress_checked<decompress_kernel_1da>},
+    {"1db", compress_kernel_1db, decompress_checked<decompress_kernel_1db>},
+    {"1ea", compress_kernel_1ea, decompress_checked<decompress_kernel_1ea>},
+    {"1eb", compress_kernel_1eb, decompress_checked<decompress_kernel_1eb>},
+    {"1ec", compress_kernel_1ec, decompress_checked<decompress_kernel_1ec>},
+    {"2a",  compress_kernel_2a,  decompress_checked<decompress_kernel_2a>},
+    {"3a",  compress_kernel_3a,  decompress_checked<decompress_kernel_3a>},
+    {"3b",  compress_kernel_3b,  decompress_checked<decompress_kernel_3b>},
+    {"lz77", compress_lz77,      decompress_lz77_tokens}
+}};
+
+bool is_valid_kernel_index(int kernel_index) {
+    return kernel_index >= 1 && kernel_index <= kernel_count;
+}
+
+bool is_valid_codec_index(int codec_index) {
+    return codec_index >= 1 && codec_index <= codec_count;
+}
+
+const KernelEntry& get_kernel_entry(int kernel_index) {
+    if (!is_valid_kernel_index(kernel_index)) {
+        throw std::out_of_range("Invalid kernel index: " + std::to_string(kernel_index));
+    }
+    return kernel_entries[kernel_index - 1];
+}
+
+const KernelEntry& get_codec_entry(int codec_index) {
+    if (!is_valid_codec_index(codec_index)) {
+        throw std::out_of_range("Invalid kernel index: " + std::to_string(codec_index));
+    }
+    return kernel_entries[codec_index - 1];
+}
+
+void compress_with_kernel(int kernel_index, const std::string& input, std::string& output) {
+    const KernelEntry& entry = get_codec_entry(kernel_index);
+    KernelCallTimer timer(kernel_index, KernelOperation::compress, input.size());
+    ProfileScope scope(profile_region(kernel_index, KernelOperation::compress), input.size());
+    entry.compress(input, output);
+    timer.done(output.size());
+}
+
+void decompress_with_kernel(int kernel_index, const std::string& input, std::string& output,
+                            std::size_t max_size) {
+    const KernelEntry& entry = get_codec_entry(kernel_index);
+    KernelCallTimer timer(kernel_index, KernelOperation::decompress, input.size());
+    ProfileScope scope(profile_region(kernel_index, KernelOperation::decompress), input.size());
+    entry.decompress(input, output, max_size);
+    timer.done(output.size());
+}
+
+} // namespace easy_compress_dlib
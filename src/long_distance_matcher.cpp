@@ -0,0 +1,91 @@
+#include "../include/easy_compress_dlib/long_distance_matcher.h"
+#include "../include/easy_compress_dlib/lz77_codec.h"
+#include "../include/easy_compress_dlib/rolling_hash.h"
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+
+namespace easy_compress_dlib {
+
+std::vector<LdmMatch> find_long_distance_matches(std::string_view input, const LdmOptions& options) {
+    if (input.size() >= std::numeric_limits<std::uint32_t>::max()) {
+        throw std::invalid_argument("Long-distance matching is limited to inputs below 4 GB");
+    }
+    if (options.anchor_log == 0 || options.anchor_log > 24) {
+        throw std::invalid_argument("anchor_log must be in the range 1 to 24");
+    }
+
+    // About one slot per expected anchor; slot 0 means empty, so positions are stored + 1
+    unsigned table_log = 10;
+    while (table_log < 32 && (std::size_t(1) << table_log) < (input.size() >> options.anchor_log)) {
+        ++table_log;
+    }
+    std::vector<std::uint32_t> table(std::size_t(1) << table_log, 0);
+    const unsigned anchor_shift = 64 - options.anchor_log;
+    const unsigned slot_shift = anchor_shift - table_log;
+    const std::uint64_t slot_mask = (std::uint64_t(1) << table_log) - 1;
+
+    std::vector<LdmMatch> matches;
+    std::size_t covered = 0;       // end of the last match; matches never extend back past it
+    std::size_t warm = 0;          // hash covers a full window from here on
+    std::uint64_t hash = 0;
+    for (std::size_t p = 0; p < input.size(); ++p) {
+        hash = gear_roll(hash, static_cast<unsigned char>(input[p]));
+        if (p + 1 < warm + gear_window || (hash >> anchor_shift) != 0) {
+            continue;
+        }
+
+        std::uint32_t& slot = table[(hash >> slot_shift) & slot_mask];
+        const std::size_t candidate = slot;   // position + 1 of an earlier anchor, 0 = none
+        slot = static_cast<std::uint32_t>(p + 1);
+        if (candidate == 0) {
+            continue;
+        }
+
+        // Extend around the anchor; the anchor byte itself is at candidate - 1
+        const std::size_t c = candidate - 1;
+        std::size_t forward = 0;
+        while (p + forward < input.size() && input[c + forward] == input[p + forward]) {
+            ++forward;
+        }
+        std::size_t backward = 0;
+        while (backward < c && p - backward > covered && input[c - backward - 1] == input[p - backward - 1]) {
+            ++backward;
+        }
+        const std::size_t length = forward + backward;
+        if (forward == 0 || length < options.min_match_length) {
+            continue;   // hash collision or too short to beat the normal parser
+        }
+
+        matches.push_back({p - backward, length, p - c});
+        covered = p + forward;
+        p = covered - 1;
+        warm = covered;
+        hash = 0;
+    }
+    return matches;
+}
+
+void compress_lz77_ldm(std::string_view input, std::string& output, const LdmOptions& options) {
+    const std::vector<LdmMatch> matches = find_long_distance_matches(input, options);
+
+    lz77_kernel kernel(lz77_total_limit, lz77_lookahead_limit);
+    output.clear();
+    std::size_t position = 0;
+    for (const auto& match : matches) {
+        lz77_encode(kernel, input.substr(position, match.position - position), output);
+        put_lz77_match(output, match.length, match.distance);
+
+        // The matched bytes become history for the parser. A match longer than
+        // the window replaces the history entirely.
+        std::string_view matched = input.substr(match.position, match.length);
+        if (matched.size() >= kernel.get_history_buffer_limit()) {
+            kernel.clear();
+        }
+        lz77_prime(kernel, matched);
+        position = match.position + match.length;
+    }
+    lz77_encode(kernel, input.substr(position), output);
+}
+
+} // namespace easy_compress_dlib
@@ -0,0 +1,208 @@
+#include "../include/easy_compress_dlib/lz77_codec.h"
+#include "../include/easy_compress_dlib/hw_profiler.h"
+#include "../include/easy_compress_dlib/metrics.h"
+#include "../include/easy_compress_dlib/run_detector.h"
+#include <cstring>
+#include <stdexcept>
+
+namespace easy_compress_dlib {
+
+namespace {
+
+void put_token(std::string& out, Lz77TokenKind kind, std::uint64_t length) {
+    put_varint(out, (length << 2) | static_cast<std::uint64_t>(kind));
+}
+
+} // namespace
+
+void put_lz77_match(std::string& output, std::uint64_t length, std::uint64_t distance) {
+    put_token(output, Lz77TokenKind::match, length);
+    put_varint(output, distance);
+}
+
+namespace {
+
+template <typename Kernel>
+void prime(Kernel& kernel, std::string_view history) {
+    if (history.size() > kernel.get_history_buffer_limit()) {
+        history.remove_prefix(history.size() - kernel.get_history_buffer_limit());
+    }
+    for (char c : history) {
+        kernel.add(static_cast<unsigned char>(c));   // shifts once the lookahead buffer is full
+    }
+    if (kernel.get_lookahead_buffer_size() != 0) {
+        kernel.shift_buffers(kernel.get_lookahead_buffer_size());
+    }
+}
+
+// Bring the kernel's history up to date after a run token. Long runs would
+// cost a hash insertion per byte and leave one huge hash chain, so they
+// restart the history from the end of the run instead; either way the history
+// ends with exactly the bytes the decoder has just produced.
+template <typename Kernel>
+void skip_run(Kernel& kernel, std::string_view run) {
+    if (run.size() >= lz77_run_reset_length) {
+        kernel.clear();
+        run = run.substr(run.size() - lz77_min_run_length);
+    }
+    prime(kernel, run);
+}
+
+template <typename Kernel>
+void encode(Kernel& kernel, std::string_view input, std::string& output) {
+    ProfileScope scope(profile_region(ProfileRegion::lz77_parse), input.size());
+    std::size_t position = 0;
+    while (position < input.size()) {
+        const ByteRun run = find_run(input, position, lz77_min_run_length);
+        lz77_encode_segment(kernel, input.substr(position, run.position - position), output);
+        if (run.length == 0) {
+            break;
+        }
+        put_token(output, Lz77TokenKind::run, run.length);
+        output.push_back(static_cast<char>(run.value));
+        skip_run(kernel, input.substr(run.position, run.length));
+        position = run.position + run.length;
+    }
+}
+
+} // namespace
+
+void lz77_prime(lz77_kernel& kernel, std::string_view history) {
+    prime(kernel, history);
+}
+
+void lz77_prime(lz77_arena_kernel& kernel, std::string_view history) {
+    prime(kernel, history);
+}
+
+void lz77_encode(lz77_kernel& kernel, std::string_view input, std::string& output) {
+    encode(kernel, input, output);
+}
+
+void lz77_encode(lz77_arena_kernel& kernel, std::string_view input, std::string& output) {
+    encode(kernel, input, output);
+}
+
+void lz77_decode(std::string_view tokens, std::string& output, std::size_t max_size) {
+    const std::size_t start_size = output.size();
+    // Checked before every append, so a crafted length never reaches resize
+    auto check_room = [&](std::uint64_t length) {
+        if (length > max_size - (output.size() - start_size)) {
+            throw std::runtime_error("LZ77 output exceeds the expected size");
+        }
+    };
+    while (!tokens.empty()) {
+        std::uint64_t tag = 0;
+        if (!get_varint(tokens, tag)) {
+            throw std::runtime_error("Truncated LZ77 token");
+        }
+        const std::uint64_t length = tag >> 2;
+        switch (static_cast<Lz77TokenKind>(tag & 3)) {
+            case Lz77TokenKind::literals:
+                if (length > tokens.size()) {
+                    throw std::runtime_error("Truncated LZ77 literals");
+                }
+                check_room(length);
+                output.append(tokens.substr(0, length));
+                tokens.remove_prefix(length);
+                break;
+            case Lz77TokenKind::match: {
+                std::uint64_t distance = 0;
+                if (!get_varint(tokens, distance) || distance == 0 || distance > output.size() || length == 0) {
+                    throw std::runtime_error("Malformed LZ77 match");
+                }
+                check_room(length);
+                const std::size_t start = output.size() - distance;
+                output.resize(output.size() + length);
+                char* dst = output.data() + output.size() - length;
+                const char* src = output.data() + start;
+                if (distance >= length) {
+                    std::memcpy(dst, src, length);
+                } else {
+                    // Overlapping copy repeats the last distance bytes
+                    for (std::uint64_t i = 0; i < length; ++i) {
+                        dst[i] = src[i];
+                    }
+                }
+                break;
+            }
+            case Lz77TokenKind::run:
+                if (tokens.empty()) {
+                    throw std::runtime_error("Malformed LZ77 run");
+                }
+                check_room(length);
+                output.append(length, tokens.front());
+                tokens.remove_prefix(1);
+                break;
+            default:
+                throw std::runtime_error("Unsupported LZ77 token");
+        }
+    }
+}
+
+void compress_lz77(const std::string& input, std::string& output) {
+    lz77_kernel kernel(lz77_total_limit, lz77_lookahead_limit);
+    output.clear();
+    lz77_encode(kernel, input, output);
+}
+
+// Bounded blocks bypass decompress_with_kernel, so they are timed here
+void decompress_lz77(std::string_view input, std::string& output, std::size_t max_size) {
+    KernelCallTimer timer(lz77_kernel_index, KernelOperation::decompress, input.size());
+    ProfileScope scope(profile_region(lz77_kernel_index, KernelOperation::decompress), input.size());
+    output.clear();
+    lz77_decode(input, output, max_size);
+    timer.done(output.size());
+}
+
+void compress_lz77(std::string_view input, std::string& output, MonotonicArena& arena) {
+    lz77_arena_kernel kernel(lz77_total_limit, lz77_lookahead_limit, ArenaAllocator<char>(arena));
+    output.clear();
+    encode(kernel, input, output);
+}
+
+void check_lz77_config(const Lz77Config& config) {
+    if (config.total_limit < lz77_min_total_limit || config.total_limit >= 32 ||
+        config.lookahead_limit < lz77_min_match_length ||
+        config.lookahead_limit > (1ul << (config.total_limit - 2))) {
+        throw std::invalid_argument("Invalid LZ77 window: total_limit " + std::to_string(config.total_limit) +
+                                    ", lookahead_limit " + std::to_string(config.lookahead_limit));
+    }
+}
+
+// Primed blocks bypass compress_with_kernel, so they are timed here
+void compress_lz77_primed(std::string_view history, std::string_view input, std::string& output) {
+    compress_lz77_primed(history, input, output, Lz77Config{});
+}
+
+void compress_lz77(std::string_view input, std::string& output, const Lz77Config& config) {
+    compress_lz77_primed(std::string_view(), input, output, config);
+}
+
+void compress_lz77_primed(std::string_view history, std::string_view input, std::string& output,
+                          const Lz77Config& config) {
+    check_lz77_config(config);
+    KernelCallTimer timer(lz77_kernel_index, KernelOperation::compress, input.size());
+    ProfileScope scope(profile_region(lz77_kernel_index, KernelOperation::compress), input.size());
+    lz77_kernel kernel(config.total_limit, config.lookahead_limit);
+    lz77_prime(kernel, history);
+    output.clear();
+    lz77_encode(kernel, input, output);
+    timer.done(output.size());
+}
+
+void decompress_lz77_primed(std::string_view history, std::string_view input, std::string& output,
+                            std::size_t max_size) {
+    KernelCallTimer timer(lz77_kernel_index, KernelOperation::decompress, input.size());
+    ProfileScope scope(profile_region(lz77_kernel_index, KernelOperation::decompress), input.size());
+    if (history.size() > lz77_history_limit) {
+        history.remove_prefix(history.size() - lz77_history_limit);
+    }
+    // history may view into output, so copy it before output changes
+    std::string scratch(history);
+    lz77_decode(input, scratch, max_size);
+    output.assign(scratch, history.size());
+    timer.done(output.size());
+}
+
+} // namespace easy_compress_dlib
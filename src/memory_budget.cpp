@@ -0,0 +1,175 @@
+#include "../include/easy_compress_dlib/memory_budget.h"
+#include "../include/easy_compress_dlib/allocation_tracking.h"
+#include "../include/easy_compress_dlib/kernel_table.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <stdexcept>
+#include <thread>
+
+namespace easy_compress_dlib {
+
+namespace {
+
+constexpr std::size_t KiB = 1024;
+constexpr std::size_t MiB = 1024 * KiB;
+
+// Rough model sizes of the dlib kernels, in kernel index order; the
+// higher-order and PPM models grow with their context trees up to these
+std::array<std::atomic<std::size_t>, kernel_count * kernel_operation_count> model_memory = {
+    16 * KiB, 16 * KiB,     // 1a
+    1 * MiB, 1 * MiB,       // 1b
+    16 * MiB, 16 * MiB,     // 1c
+    8 * MiB, 8 * MiB,       // 1da
+    32 * MiB, 32 * MiB,     // 1db
+    8 * MiB, 8 * MiB,       // 1ea
+    32 * MiB, 32 * MiB,     // 1eb
+    80 * MiB, 80 * MiB,     // 1ec
+    8 * MiB, 8 * MiB,       // 2a
+    8 * MiB, 8 * MiB,       // 3a
+    32 * MiB, 32 * MiB,     // 3b
+};
+
+std::atomic<std::size_t>& model_slot(int kernel_index, KernelOperation operation) {
+    get_kernel_entry(kernel_index); // validates the index
+    return model_memory[(kernel_index - 1) * kernel_operation_count + static_cast<std::size_t>(operation)];
+}
+
+void format_mib(char* buffer, std::size_t size, std::size_t bytes) {
+    std::snprintf(buffer, size, "%.2f", static_cast<double>(bytes) / MiB);
+}
+
+} // namespace
+
+std::size_t lz77_kernel_memory(const Lz77Config& config) {
+    check_lz77_config(config);
+    const std::size_t window = std::size_t(1) << config.total_limit;
+    // kernel_2's node is an unsigned long id and a next pointer
+    const std::size_t node_size = sizeof(unsigned long) + sizeof(void*);
+    const std::size_t nodes = window - config.lookahead_limit - 3;
+    return window + nodes * node_size + 2 * window * sizeof(void*);
+}
+
+Lz77Config lz77_config_for_memory(std::size_t bytes) {
+    Lz77Config config;
+    for (unsigned long total_limit = lz77_total_limit; total_limit >= lz77_min_total_limit; --total_limit) {
+        config.total_limit = total_limit;
+        config.lookahead_limit = std::min(lz77_lookahead_limit, 1ul << (total_limit - 2));
+        if (lz77_kernel_memory(config) <= bytes) {
+            break;
+        }
+    }
+    return config;
+}
+
+std::size_t kernel_model_memory(int codec_index, KernelOperation operation, const Lz77Config& config) {
+    get_codec_entry(codec_index); // validates the index
+    if (codec_index == lz77_kernel_index) {
+        return operation == KernelOperation::compress ? lz77_kernel_memory(config) : 0;
+    }
+    return model_slot(codec_index, operation).load(std::memory_order_relaxed);
+}
+
+std::size_t kernel_call_memory(int codec_index, KernelOperation operation, std::size_t raw_size,
+                               const Lz77Config& config) {
+    // The compressed side is counted at raw_size too, which covers
+    // incompressible blocks
+    return kernel_model_memory(codec_index, operation, config) + 2 * raw_size;
+}
+
+void set_kernel_model_memory(int codec_index, KernelOperation operation, std::size_t bytes) {
+    model_slot(codec_index, operation).store(bytes, std::memory_order_relaxed);
+}
+
+bool calibrate_kernel_memory(int codec_index, const std::string& sample) {
+    get_kernel_entry(codec_index); // validates the index
+    if (!allocation_tracking_available()) {
+        return false;
+    }
+    auto model = [&](const AllocationScope& scope, std::size_t output_size) {
+        const std::size_t allocated = static_cast<std::size_t>(scope.stats().bytes);
+        const std::size_t data = sample.size() + output_size;
+        return allocated > data ? allocated - data : 0;
+    };
+    std::string compressed;
+    std::size_t compress_model = 0;
+    {
+        AllocationScope scope;
+        compress_with_kernel(codec_index, sample, compressed);
+        compress_model = model(scope, compressed.size());
+    }
+    std::string restored;
+    std::size_t decompress_model = 0;
+    {
+        AllocationScope scope;
+        decompress_with_kernel(codec_index, compressed, restored, sample.size());
+        decompress_model = model(scope, restored.size());
+    }
+    set_kernel_model_memory(codec_index, KernelOperation::compress, compress_model);
+    set_kernel_model_memory(codec_index, KernelOperation::decompress, decompress_model);
+    return true;
+}
+
+std::string memory_report(std::size_t raw_size, const Lz77Config& config) {
+    std::string out;
+    char line[256];
+    std::snprintf(line, sizeof(line), "%-8s %14s %14s %14s %14s\n", "codec", "model c MiB", "model d MiB",
+                  "call c MiB", "call d MiB");
+    out += line;
+    for (int codec = 1; codec <= codec_count; ++codec) {
+        char model_c[32], model_d[32], call_c[32], call_d[32];
+        format_mib(model_c, sizeof(model_c), kernel_model_memory(codec, KernelOperation::compress, config));
+        format_mib(model_d, sizeof(model_d), kernel_model_memory(codec, KernelOperation::decompress, config));
+        format_mib(call_c, sizeof(call_c), kernel_call_memory(codec, KernelOperation::compress, raw_size, config));
+        format_mib(call_d, sizeof(call_d), kernel_call_memory(codec, KernelOperation::decompress, raw_size, config));
+        std::snprintf(line, sizeof(line), "%-8s %14s %14s %14s %14s\n", get_codec_entry(codec).name, model_c,
+                      model_d, call_c, call_d);
+        out += line;
+    }
+    std::snprintf(line, sizeof(line), "lz77 window 2^%lu, lookahead %lu; blocks of %zu bytes\n", config.total_limit,
+                  config.lookahead_limit, raw_size);
+    out += line;
+    return out;
+}
+
+std::size_t MemoryBudget::acquire(std::size_t bytes) {
+    if (limit_ == 0) {
+        return 0;
+    }
+    bytes = std::min(bytes, limit_);
+    std::unique_lock<std::mutex> lock(mutex_);
+    freed_.wait(lock, [&] { return in_use_ + bytes <= limit_; });
+    in_use_ += bytes;
+    return bytes;
+}
+
+void MemoryBudget::release(std::size_t reserved) {
+    if (reserved == 0) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        in_use_ -= reserved;
+    }
+    freed_.notify_all();
+}
+
+std::size_t MemoryBudget::in_use() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return in_use_;
+}
+
+Lz77Config lz77_config_for_budget(std::size_t memory_limit, unsigned threads, std::size_t block_size) {
+    if (memory_limit == 0) {
+        return Lz77Config{};
+    }
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    const std::size_t share = memory_limit / threads;
+    const std::size_t data = 2 * block_size;
+    return lz77_config_for_memory(share > data ? share - data : 0);
+}
+
+} // namespace easy_compress_dlib
@@ -0,0 +1,326 @@
+#include "../include/easy_compress_dlib/metrics.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace easy_compress_dlib {
+
+namespace {
+
+using metrics_detail::Histogram;
+using metrics_detail::ThreadMetrics;
+
+// Never destroyed, so threads may still exit during static destruction
+struct Registry {
+    std::mutex mutex;
+    std::vector<const ThreadMetrics*> live;
+    MetricsSnapshot retired;   // counts of threads that have exited
+    MetricsSnapshot base;      // raw counts at the last reset_metrics
+};
+
+Registry& registry() {
+    static Registry* instance = new Registry;
+    return *instance;
+}
+
+void add_histogram(HistogramSnapshot& to, const Histogram& from) {
+    for (std::size_t b = 0; b < histogram_buckets; ++b) {
+        to.buckets[b] += from.buckets[b].get();
+    }
+    to.sum += from.sum.get();
+}
+
+void add_thread(MetricsSnapshot& to, const ThreadMetrics& from) {
+    for (std::size_t k = 0; k < codec_count; ++k) {
+        for (std::size_t op = 0; op < kernel_operation_count; ++op) {
+            KernelCallSnapshot& kernel = to.kernels[k][op];
+            const metrics_detail::KernelCounters& counters = from.kernels[k][op];
+            kernel.calls += counters.calls.get();
+            kernel.errors += counters.errors.get();
+            kernel.bytes_in += counters.bytes_in.get();
+            kernel.bytes_out += counters.bytes_out.get();
+            kernel.allocations += counters.allocations.get();
+            kernel.allocated_bytes += counters.allocated_bytes.get();
+            add_histogram(kernel.latency_ns, counters.latency_ns);
+        }
+        to.selections[k] += from.selections[k].get();
+    }
+    to.find_match_calls += from.find_match_calls.get();
+    to.find_match_matches += from.find_match_matches.get();
+    to.matched_bytes += from.matched_bytes.get();
+    add_histogram(to.chain_length, from.chain_length);
+}
+
+void subtract_histogram(HistogramSnapshot& from, const HistogramSnapshot& base) {
+    for (std::size_t b = 0; b < histogram_buckets; ++b) {
+        from.buckets[b] -= base.buckets[b];
+    }
+    from.sum -= base.sum;
+}
+
+void subtract(MetricsSnapshot& from, const MetricsSnapshot& base) {
+    for (std::size_t k = 0; k < codec_count; ++k) {
+        for (std::size_t op = 0; op < kernel_operation_count; ++op) {
+            KernelCallSnapshot& kernel = from.kernels[k][op];
+            const KernelCallSnapshot& old = base.kernels[k][op];
+            kernel.calls -= old.calls;
+            kernel.errors -= old.errors;
+            kernel.bytes_in -= old.bytes_in;
+            kernel.bytes_out -= old.bytes_out;
+            kernel.allocations -= old.allocations;
+            kernel.allocated_bytes -= old.allocated_bytes;
+            subtract_histogram(kernel.latency_ns, old.latency_ns);
+        }
+        from.selections[k] -= base.selections[k];
+    }
+    from.find_match_calls -= base.find_match_calls;
+    from.find_match_matches -= base.find_match_matches;
+    from.matched_bytes -= base.matched_bytes;
+    subtract_histogram(from.chain_length, base.chain_length);
+}
+
+// Caller holds the registry mutex
+MetricsSnapshot collect_raw(const Registry& r) {
+    MetricsSnapshot snapshot = r.retired;
+    for (const ThreadMetrics* metrics : r.live) {
+        add_thread(snapshot, *metrics);
+    }
+    return snapshot;
+}
+
+// Folds the thread's counts into the retired totals when it exits
+struct ThreadSlot {
+    std::unique_ptr<ThreadMetrics> metrics;
+
+    ~ThreadSlot() {
+        if (!metrics) {
+            return;
+        }
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        add_thread(r.retired, *metrics);
+        r.live.erase(std::find(r.live.begin(), r.live.end(), metrics.get()));
+        metrics_detail::current_thread = nullptr;
+    }
+};
+
+thread_local ThreadSlot thread_slot;
+
+std::string format_number(double value) {
+    char number[32];
+    std::snprintf(number, sizeof(number), "%.9g", value);
+    return number;
+}
+
+std::string kernel_labels(std::size_t k, std::size_t op) {
+    return std::string("kernel=\"") + get_codec_entry(static_cast<int>(k) + 1).name + "\",operation=\"" +
+           kernel_operation_name(static_cast<KernelOperation>(op)) + "\"";
+}
+
+void put_type(std::string& out, const char* name, const char* type, const char* help) {
+    out += std::string("# HELP ") + name + " " + help + "\n# TYPE " + name + " " + type + "\n";
+}
+
+// scale converts recorded values to the exported unit
+void put_prometheus_histogram(std::string& out, const std::string& name, const std::string& labels,
+                              const HistogramSnapshot& histogram, double scale) {
+    const std::string prefix = labels.empty() ? "{" : "{" + labels + ",";
+    std::uint64_t cumulative = 0;
+    for (std::size_t b = 0; b + 1 < histogram_buckets; ++b) {
+        cumulative += histogram.buckets[b];
+        // Values are integers, so bucket b holds values up to its limit - 1
+        const double le = (HistogramSnapshot::bucket_limit(b) - 1) * scale;
+        out += name + "_bucket" + prefix + "le=\"" + format_number(le) + "\"} " + std::to_string(cumulative) + "\n";
+    }
+    out += name + "_bucket" + prefix + "le=\"+Inf\"} " + std::to_string(histogram.count()) + "\n";
+    const std::string suffix = labels.empty() ? "" : "{" + labels + "}";
+    out += name + "_sum" + suffix + " " + format_number(histogram.sum * scale) + "\n";
+    out += name + "_count" + suffix + " " + std::to_string(histogram.count()) + "\n";
+}
+
+void put_json_histogram(std::string& out, const HistogramSnapshot& histogram) {
+    out += "{\"count\": " + std::to_string(histogram.count());
+    out += ", \"sum\": " + std::to_string(histogram.sum);
+    out += ", \"p50\": " + std::to_string(histogram.percentile(50));
+    out += ", \"p99\": " + std::to_string(histogram.percentile(99));
+    out += ", \"buckets\": [";
+    for (std::size_t b = 0; b < histogram_buckets; ++b) {
+        if (b != 0) {
+            out.push_back(',');
+        }
+        out += std::to_string(histogram.buckets[b]);
+    }
+    out += "]}";
+}
+
+} // namespace
+
+const char* kernel_operation_name(KernelOperation operation) {
+    return operation == KernelOperation::compress ? "compress" : "decompress";
+}
+
+std::uint64_t HistogramSnapshot::count() const {
+    std::uint64_t total = 0;
+    for (std::uint64_t n : buckets) {
+        total += n;
+    }
+    return total;
+}
+
+std::uint64_t HistogramSnapshot::bucket_limit(std::size_t bucket) {
+    return bucket + 1 < histogram_buckets ? std::uint64_t(1) << bucket : 0;
+}
+
+std::uint64_t HistogramSnapshot::percentile(double p) const {
+    const std::uint64_t total = count();
+    if (total == 0) {
+        return 0;
+    }
+    const double rank = std::max(1.0, std::ceil(p / 100.0 * total));
+    std::uint64_t seen = 0;
+    for (std::size_t b = 0; b < histogram_buckets; ++b) {
+        seen += buckets[b];
+        if (seen >= rank) {
+            // The open last bucket reports its lower bound
+            return b + 1 < histogram_buckets ? bucket_limit(b) : std::uint64_t(1) << (b - 1);
+        }
+    }
+    return 0;
+}
+
+const KernelCallSnapshot& MetricsSnapshot::kernel(int codec_index, KernelOperation operation) const {
+    if (!is_valid_codec_index(codec_index)) {
+        throw std::out_of_range("Invalid kernel index: " + std::to_string(codec_index));
+    }
+    return kernels[codec_index - 1][static_cast<std::size_t>(operation)];
+}
+
+namespace metrics_detail {
+
+ThreadMetrics& register_thread() {
+    thread_slot.metrics = std::make_unique<ThreadMetrics>();
+    Registry& r = registry();
+    {
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.live.push_back(thread_slot.metrics.get());
+    }
+    current_thread = thread_slot.metrics.get();
+    return *current_thread;
+}
+
+} // namespace metrics_detail
+
+MetricsSnapshot collect_metrics() {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    MetricsSnapshot snapshot = collect_raw(r);
+    subtract(snapshot, r.base);
+    return snapshot;
+}
+
+void reset_metrics() {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.base = collect_raw(r);
+}
+
+std::string metrics_prometheus(const MetricsSnapshot& snapshot) {
+    std::string out;
+    struct KernelCounter {
+        const char* name;
+        const char* help;
+        std::uint64_t KernelCallSnapshot::*field;
+    };
+    const KernelCounter counters[] = {
+        {"easy_compress_kernel_calls_total", "Kernel calls, including failed ones", &KernelCallSnapshot::calls},
+        {"easy_compress_kernel_errors_total", "Kernel calls that threw", &KernelCallSnapshot::errors},
+        {"easy_compress_kernel_bytes_in_total", "Bytes passed to kernels", &KernelCallSnapshot::bytes_in},
+        {"easy_compress_kernel_bytes_out_total", "Bytes produced by kernels", &KernelCallSnapshot::bytes_out},
+        {"easy_compress_kernel_allocations_total", "Heap allocations during kernel calls",
+         &KernelCallSnapshot::allocations},
+        {"easy_compress_kernel_allocated_bytes_total", "Bytes allocated during kernel calls",
+         &KernelCallSnapshot::allocated_bytes},
+    };
+    for (const auto& counter : counters) {
+        put_type(out, counter.name, "counter", counter.help);
+        for (std::size_t k = 0; k < codec_count; ++k) {
+            for (std::size_t op = 0; op < kernel_operation_count; ++op) {
+                out += std::string(counter.name) + "{" + kernel_labels(k, op) + "} " +
+                       std::to_string(snapshot.kernels[k][op].*counter.field) + "\n";
+            }
+        }
+    }
+
+    put_type(out, "easy_compress_kernel_seconds", "histogram", "Latency of successful kernel calls");
+    for (std::size_t k = 0; k < codec_count; ++k) {
+        for (std::size_t op = 0; op < kernel_operation_count; ++op) {
+            const HistogramSnapshot& latency = snapshot.kernels[k][op].latency_ns;
+            if (latency.count() != 0) {
+                put_prometheus_histogram(out, "easy_compress_kernel_seconds", kernel_labels(k, op), latency, 1e-9);
+            }
+        }
+    }
+
+    put_type(out, "easy_compress_kernel_selections_total", "counter", "Kernels chosen by kernel selection");
+    for (std::size_t k = 0; k < codec_count; ++k) {
+        out += std::string("easy_compress_kernel_selections_total{kernel=\"") +
+               get_codec_entry(static_cast<int>(k) + 1).name + "\"} " + std::to_string(snapshot.selections[k]) +
+               "\n";
+    }
+
+    put_type(out, "easy_compress_lz77_find_match_calls_total", "counter", "LZ77 find_match calls");
+    out += "easy_compress_lz77_find_match_calls_total " + std::to_string(snapshot.find_match_calls) + "\n";
+    put_type(out, "easy_compress_lz77_matches_total", "counter", "LZ77 find_match calls that found a match");
+    out += "easy_compress_lz77_matches_total " + std::to_string(snapshot.find_match_matches) + "\n";
+    put_type(out, "easy_compress_lz77_matched_bytes_total", "counter", "Bytes covered by LZ77 matches");
+    out += "easy_compress_lz77_matched_bytes_total " + std::to_string(snapshot.matched_bytes) + "\n";
+    put_type(out, "easy_compress_lz77_chain_length", "histogram", "Candidate positions examined per find_match call");
+    put_prometheus_histogram(out, "easy_compress_lz77_chain_length", "", snapshot.chain_length, 1.0);
+    return out;
+}
+
+std::string metrics_json(const MetricsSnapshot& snapshot) {
+    std::string out = "{\n  \"schema\": \"easy_compress_dlib.metrics.v1\",\n  \"kernels\": [";
+    bool first = true;
+    for (std::size_t k = 0; k < codec_count; ++k) {
+        for (std::size_t op = 0; op < kernel_operation_count; ++op) {
+            const KernelCallSnapshot& kernel = snapshot.kernels[k][op];
+            if (kernel.calls == 0) {
+                continue;
+            }
+            out += first ? "\n    {" : ",\n    {";
+            first = false;
+            out += std::string("\"kernel\": \"") + get_codec_entry(static_cast<int>(k) + 1).name + "\"";
+            out += std::string(", \"operation\": \"") + kernel_operation_name(static_cast<KernelOperation>(op)) + "\"";
+            out += ", \"calls\": " + std::to_string(kernel.calls);
+            out += ", \"errors\": " + std::to_string(kernel.errors);
+            out += ", \"bytes_in\": " + std::to_string(kernel.bytes_in);
+            out += ", \"bytes_out\": " + std::to_string(kernel.bytes_out);
+            out += ", \"allocations\": " + std::to_string(kernel.allocations);
+            out += ", \"allocated_bytes\": " + std::to_string(kernel.allocated_bytes);
+            out += ", \"latency_ns\": ";
+            put_json_histogram(out, kernel.latency_ns);
+            out += "}";
+        }
+    }
+    out += "\n  ],\n  \"selections\": {";
+    for (std::size_t k = 0; k < codec_count; ++k) {
+        out += k == 0 ? "" : ", ";
+        out += std::string("\"") + get_codec_entry(static_cast<int>(k) + 1).name + "\": " +
+               std::to_string(snapshot.selections[k]);
+    }
+    out += "},\n  \"lz77\": {\"find_match_calls\": " + std::to_string(snapshot.find_match_calls);
+    out += ", \"matches\": " + std::to_string(snapshot.find_match_matches);
+    out += ", \"matched_bytes\": " + std::to_string(snapshot.matched_bytes);
+    out += ", \"chain_length\": ";
+    put_json_histogram(out, snapshot.chain_length);
+    out += "}\n}\n";
+    return out;
+}
+
+} // namespace easy_compress_dlib
@@ -0,0 +1,227 @@
+#include "../include/easy_compress_dlib/online_selector.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+namespace easy_compress_dlib {
+
+namespace {
+
+int checked_file_type_index(const std::string& file_type) {
+    int type = file_type_index(file_type);
+    if (type < 0) {
+        throw std::invalid_argument("Unknown file type: " + file_type);
+    }
+    return type;
+}
+
+std::mt19937_64& thread_rng() {
+    thread_local std::mt19937_64 rng(std::random_device{}());
+    return rng;
+}
+
+} // namespace
+
+OnlineKernelSelector::OnlineKernelSelector(OnlineSelectorOptions options) : options_(std::move(options)) {
+    if (!options_.persist_path.empty()) {
+        persist_thread_ = std::thread([this] { persist_loop(); });
+    }
+}
+
+OnlineKernelSelector::~OnlineKernelSelector() {
+    if (persist_thread_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(persist_mutex_);
+            stopping_ = true;
+        }
+        persist_wake_.notify_all();
+        persist_thread_.join();
+    }
+}
+
+const KernelObservation& OnlineKernelSelector::observation(int type, int kernel_index) const {
+    get_kernel_entry(kernel_index); // validates the index
+    return observations_[type][kernel_index - 1];
+}
+
+KernelObservation& OnlineKernelSelector::observation(int type, int kernel_index) {
+    get_kernel_entry(kernel_index);
+    return observations_[type][kernel_index - 1];
+}
+
+OnlineKernelSelector::Estimate OnlineKernelSelector::estimate(const KernelMetricsSet& metrics, int type,
+                                                              int kernel_index) const {
+    const auto& obs = observations_[type][kernel_index - 1];
+    const auto& prior = metrics[kernel_index - 1];
+    const double prior_bytes = options_.prior_weight_bytes;
+    const double original = prior_bytes + obs.original_bytes.load(std::memory_order_relaxed);
+    // Same units as get_kernel_bpb and get_kernel_throughput
+    const double compressed = prior.bpbs[type] / 8.0 * prior_bytes +
+                              obs.compressed_bytes.load(std::memory_order_relaxed);
+    const double seconds = prior_bytes * prior.compression_time / 1000.0 / metrics_corpus_size +
+                           obs.nanoseconds.load(std::memory_order_relaxed) * 1e-9;
+    return {8.0 * compressed / original, original / seconds};
+}
+
+double OnlineKernelSelector::estimated_bpb(const std::string& file_type, int kernel_index) const {
+    const int type = checked_file_type_index(file_type);
+    get_kernel_entry(kernel_index); // validates the index
+    return estimate(*current_kernel_metrics(), type, kernel_index).bpb;
+}
+
+double OnlineKernelSelector::estimated_throughput(const std::string& file_type, int kernel_index) const {
+    const int type = checked_file_type_index(file_type);
+    get_kernel_entry(kernel_index);
+    return estimate(*current_kernel_metrics(), type, kernel_index).throughput;
+}
+
+std::uint64_t OnlineKernelSelector::sample_count(const std::string& file_type, int kernel_index) const {
+    return observation(checked_file_type_index(file_type), kernel_index).samples.load(std::memory_order_relaxed);
+}
+
+int OnlineKernelSelector::select(const std::string& file_type, double alpha) const {
+    const int type = checked_file_type_index(file_type);
+
+    auto& rng = thread_rng();
+    if (std::uniform_real_distribution<double>(0.0, 1.0)(rng) < options_.exploration_rate) {
+        return std::uniform_int_distribution<int>(1, kernel_count)(rng);
+    }
+
+    // One metrics load and one pass over the kernels of this type
+    const auto metrics = current_kernel_metrics();
+    std::array<Estimate, kernel_count> estimates;
+    double avg_bpb = 0.0, avg_throughput = 0.0;
+    for (int k = 1; k <= kernel_count; ++k) {
+        estimates[k - 1] = estimate(*metrics, type, k);
+        avg_bpb += estimates[k - 1].bpb;
+        avg_throughput += estimates[k - 1].throughput;
+    }
+    avg_bpb /= kernel_count;
+    avg_throughput /= kernel_count;
+
+    // Same shape as select_best_kernel: both terms relative to the average
+    int best_kernel = 1;
+    double best_score = 0.0;
+    for (int k = 1; k <= kernel_count; ++k) {
+        const Estimate& e = estimates[k - 1];
+        const double s = alpha * (avg_bpb / e.bpb) + (1 - alpha) * (e.throughput / avg_throughput);
+        if (k == 1 || s > best_score) {
+            best_score = s;
+            best_kernel = k;
+        }
+    }
+    return best_kernel;
+}
+
+void OnlineKernelSelector::record(const std::string& file_type, int kernel_index, std::size_t original_size,
+                                  std::size_t compressed_size, std::chrono::nanoseconds elapsed) {
+    auto& obs = observation(checked_file_type_index(file_type), kernel_index);
+    obs.samples.fetch_add(1, std::memory_order_relaxed);
+    obs.original_bytes.fetch_add(original_size, std::memory_order_relaxed);
+    obs.compressed_bytes.fetch_add(compressed_size, std::memory_order_relaxed);
+    obs.nanoseconds.fetch_add(static_cast<std::uint64_t>(std::max<std::int64_t>(0, elapsed.count())),
+                              std::memory_order_relaxed);
+}
+
+void OnlineKernelSelector::record(const std::string& file_type, int kernel_index, const CompressionMetricEntry& entry,
+                                  std::chrono::nanoseconds elapsed) {
+    record(file_type, kernel_index, entry.original_size, entry.compressed_size, elapsed);
+}
+
+int OnlineKernelSelector::compress(const std::string& file_type, double alpha, const std::string& input,
+                                   std::string& output) {
+    int kernel = select(file_type, alpha);
+    auto start = std::chrono::steady_clock::now();
+    compress_with_kernel(kernel, input, output);
+    record(file_type, kernel, input.size(), output.size(), std::chrono::steady_clock::now() - start);
+    return kernel;
+}
+
+void OnlineKernelSelector::save(const std::string& filename) const {
+    // Write to a temporary file and rename so readers never see a partial file
+    const std::string temp_filename = filename + ".tmp";
+    {
+        std::ofstream file(temp_filename);
+        if (!file.is_open()) {
+            throw std::runtime_error("Failed to open file for writing");
+        }
+        for (std::size_t type = 0; type < known_file_types.size(); ++type) {
+            for (int k = 1; k <= kernel_count; ++k) {
+                const auto& obs = observations_[type][k - 1];
+                std::uint64_t samples = obs.samples.load(std::memory_order_relaxed);
+                if (samples == 0) {
+                    continue;
+                }
+                file << known_file_types[type] << "," << k << "," << samples << ","
+                     << obs.original_bytes.load(std::memory_order_relaxed) << ","
+                     << obs.compressed_bytes.load(std::memory_order_relaxed) << ","
+                     << obs.nanoseconds.load(std::memory_order_relaxed) << std::endl;
+            }
+        }
+    }
+    if (std::rename(temp_filename.c_str(), filename.c_str()) != 0) {
+        throw std::runtime_error("Failed to replace " + filename);
+    }
+}
+
+void OnlineKernelSelector::load(const std::string& filename) {
+    std::ifstream input_file(filename);
+    if (!input_file.is_open()) {
+        throw std::runtime_error("Failed to open file: " + filename);
+    }
+
+    std::string line;
+    int line_number = 1;
+    while (std::getline(input_file, line)) {
+        std::istringstream line_stream(line);
+        std::string cell;
+        std::vector<std::string> values;
+        while (std::getline(line_stream, cell, ',')) {
+            values.push_back(cell);
+        }
+
+        if (values.size() == 6) {
+            try {
+                auto& obs = observation(checked_file_type_index(values[0]), std::stoi(values[1]));
+                obs.samples.store(std::stoull(values[2]), std::memory_order_relaxed);
+                obs.original_bytes.store(std::stoull(values[3]), std::memory_order_relaxed);
+                obs.compressed_bytes.store(std::stoull(values[4]), std::memory_order_relaxed);
+                obs.nanoseconds.store(std::stoull(values[5]), std::memory_order_relaxed);
+            } catch (const std::exception& e) {
+                std::cerr << "Error on line " << line_number << ": " << e.what() << std::endl;
+            }
+        } else {
+            std::cerr << "Incorrect format on line " << line_number << ": Expected 6 comma-separated values" << std::endl;
+        }
+        line_number++;
+    }
+}
+
+void OnlineKernelSelector::persist() {
+    if (options_.persist_path.empty()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(persist_mutex_);
+    save(options_.persist_path);
+}
+
+void OnlineKernelSelector::persist_loop() {
+    const auto interval = std::max(options_.persist_interval, std::chrono::seconds(1));
+    std::unique_lock<std::mutex> lock(persist_mutex_);
+    bool stop = false;
+    while (!stop) {
+        stop = persist_wake_.wait_for(lock, interval, [this] { return stopping_; });
+        try {
+            save(options_.persist_path);
+        } catch (const std::exception& e) {
+            std::cerr << "Failed to persist kernel metrics: " << e.what() << std::endl;
+        }
+    }
+}
+
+} // namespace easy_compress_dlib
@@ -0,0 +1,271 @@
+#include "../include/easy_compress_dlib/profile_store.h"
+#include "../include/easy_compress_dlib/compression_profile.h"
+#include "../include/easy_compress_dlib/kernel_selection.h"
+#include "../include/easy_compress_dlib/kernel_table.h"
+#include <bit>
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <unordered_set>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace easy_compress_dlib {
+
+// Records are written and mapped as host structs
+static_assert(std::endian::native == std::endian::little, "profile store requires a little endian host");
+
+namespace {
+
+std::uint64_t align_up(std::uint64_t value, std::uint64_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+} // namespace
+
+void write_profile_store(const std::vector<ProfileRecord>& profiles, const std::string& filename,
+                         std::uint64_t metrics_fingerprint) {
+    std::vector<ProfileStoreRecord> records;
+    records.reserve(profiles.size());
+    std::string strings;
+
+    // Same rule as CompressionProfiles::load_profiles: the first profile with a name wins
+    std::unordered_set<std::string_view> seen;
+    for (const auto& profile : profiles) {
+        if (!seen.insert(profile.profile_name).second) {
+            continue;
+        }
+        if (profile.profile_name.size() + profile.file_type.size() > UINT32_MAX - strings.size()) {
+            throw std::length_error("Profile store strings exceed 4 GiB");
+        }
+        ProfileStoreRecord record{};
+        record.name_offset = static_cast<std::uint32_t>(strings.size());
+        record.name_length = static_cast<std::uint32_t>(profile.profile_name.size());
+        strings += profile.profile_name;
+        record.file_type_offset = static_cast<std::uint32_t>(strings.size());
+        record.file_type_length = static_cast<std::uint32_t>(profile.file_type.size());
+        strings += profile.file_type;
+        record.alpha = profile.alpha;
+        record.kernel = profile.kernel;
+        record.name_hash = profile_name_hash(profile.profile_name);
+        records.push_back(record);
+    }
+
+    std::uint64_t slot_count = 16;
+    while (slot_count < records.size() * 2) {
+        slot_count <<= 1;
+    }
+    std::vector<std::uint32_t> slots(slot_count, 0);
+    for (std::size_t i = 0; i < records.size(); ++i) {
+        std::uint64_t slot = records[i].name_hash & (slot_count - 1);
+        while (slots[slot] != 0) {
+            slot = (slot + 1) & (slot_count - 1);
+        }
+        slots[slot] = static_cast<std::uint32_t>(i + 1);
+    }
+
+    ProfileStoreHeader header{};
+    std::memcpy(header.magic, profile_store_magic, sizeof(header.magic));
+    header.version = profile_store_version;
+    header.record_count = records.size();
+    header.slot_count = slot_count;
+    header.records_offset = sizeof(ProfileStoreHeader);
+    header.slots_offset = header.records_offset + records.size() * sizeof(ProfileStoreRecord);
+    header.strings_offset = align_up(header.slots_offset + slot_count * sizeof(std::uint32_t), 8);
+    header.strings_size = strings.size();
+    header.metrics_fingerprint = metrics_fingerprint;
+
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to open file for writing");
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(ProfileStoreRecord));
+    file.write(reinterpret_cast<const char*>(slots.data()), slots.size() * sizeof(std::uint32_t));
+    const std::uint64_t padding = header.strings_offset - (header.slots_offset + slot_count * sizeof(std::uint32_t));
+    file.write("\0\0\0\0\0\0\0", static_cast<std::streamsize>(padding));
+    file.write(strings.data(), static_cast<std::streamsize>(strings.size()));
+    if (!file) {
+        throw std::runtime_error("Failed to write profile store: " + filename);
+    }
+}
+
+std::size_t import_profiles_csv(const std::string& csv_filename, const std::string& store_filename) {
+    std::ifstream input_file(csv_filename, std::ios::binary);
+    if (!input_file.is_open()) {
+        throw std::runtime_error("Failed to open file: " + csv_filename);
+    }
+    const std::string contents((std::istreambuf_iterator<char>(input_file)), std::istreambuf_iterator<char>());
+
+    std::vector<ProfileRecord> profiles;
+    std::string_view remaining(contents);
+    int line_number = 1;
+    ProfileCsvRow row;
+    // Kernels are only trusted if the file says they were resolved with metrics
+    // of the current fingerprint
+    bool trust_kernels = false;
+    while (!remaining.empty()) {
+        std::size_t newline = remaining.find('\n');
+        std::string_view line = remaining.substr(0, newline);
+        remaining.remove_prefix(newline == std::string_view::npos ? remaining.size() : newline + 1);
+
+        if (line_number == 1 &&
+            line.substr(0, profile_metrics_fingerprint_prefix.size()) == profile_metrics_fingerprint_prefix) {
+            std::uint64_t fingerprint = 0;
+            line.remove_prefix(profile_metrics_fingerprint_prefix.size());
+            auto result = std::from_chars(line.data(), line.data() + line.size(), fingerprint);
+            trust_kernels = result.ec == std::errc() && fingerprint == kernel_metrics_fingerprint();
+            line_number++;
+            continue;
+        }
+        switch (parse_profile_csv_row(line, row)) {
+            case ProfileCsvStatus::ok: {
+                int kernel = trust_kernels && is_valid_kernel_index(row.kernel)
+                                 ? row.kernel : kernel_selection(row.file_type, row.alpha);
+                profiles.push_back({std::string(row.profile_name), std::string(row.file_type), row.alpha, kernel});
+                break;
+            }
+            case ProfileCsvStatus::bad_number:
+                std::cerr << "Error on line " << line_number << ": invalid alpha or kernel" << std::endl;
+                break;
+            case ProfileCsvStatus::wrong_field_count:
+                std::cerr << "Incorrect format on line " << line_number << ": Expected 4 comma-separated values" << std::endl;
+                break;
+        }
+        line_number++;
+    }
+
+    write_profile_store(profiles, store_filename, kernel_metrics_fingerprint());
+    return profiles.size();
+}
+
+ProfileStore::ProfileStore(const std::string& filename) {
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to open file: " + filename);
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < sizeof(ProfileStoreHeader)) {
+        ::close(fd);
+        throw std::runtime_error("Not a profile store: " + filename);
+    }
+    void* mapping = ::mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error("Failed to map file: " + filename);
+    }
+    data_ = static_cast<const char*>(mapping);
+    size_ = static_cast<std::size_t>(st.st_size);
+
+    // Validate the layout once; records are bounds-checked when read. Every
+    // section must lie between the header and the next section, compared by
+    // division so crafted counts cannot wrap the products.
+    const ProfileStoreHeader& h = header();
+    auto fits = [](std::uint64_t offset, std::uint64_t count, std::uint64_t element_size, std::uint64_t end) {
+        return offset <= end && count <= (end - offset) / element_size;
+    };
+    const bool valid =
+        std::memcmp(h.magic, profile_store_magic, sizeof(h.magic)) == 0 &&
+        h.version == profile_store_version &&
+        h.slot_count != 0 && (h.slot_count & (h.slot_count - 1)) == 0 && h.record_count < h.slot_count &&
+        h.records_offset % alignof(ProfileStoreRecord) == 0 && h.slots_offset % alignof(std::uint32_t) == 0 &&
+        h.records_offset >= sizeof(ProfileStoreHeader) && h.strings_offset <= size_ &&
+        fits(h.strings_offset, h.strings_size, 1, size_) &&
+        fits(h.slots_offset, h.slot_count, sizeof(std::uint32_t), h.strings_offset) &&
+        fits(h.records_offset, h.record_count, sizeof(ProfileStoreRecord), h.slots_offset);
+    if (!valid) {
+        unmap();
+        throw std::runtime_error("Malformed profile store: " + filename);
+    }
+}
+
+ProfileStore::~ProfileStore() {
+    unmap();
+}
+
+ProfileStore::ProfileStore(ProfileStore&& other) noexcept : data_(other.data_), size_(other.size_) {
+    other.data_ = nullptr;
+    other.size_ = 0;
+}
+
+ProfileStore& ProfileStore::operator=(ProfileStore&& other) noexcept {
+    if (this != &other) {
+        unmap();
+        data_ = other.data_;
+        size_ = other.size_;
+        other.data_ = nullptr;
+        other.size_ = 0;
+    }
+    return *this;
+}
+
+void ProfileStore::unmap() {
+    if (data_ != nullptr) {
+        ::munmap(const_cast<char*>(data_), size_);
+        data_ = nullptr;
+        size_ = 0;
+    }
+}
+
+const ProfileStoreRecord* ProfileStore::records() const {
+    return reinterpret_cast<const ProfileStoreRecord*>(data_ + header().records_offset);
+}
+
+const std::uint32_t* ProfileStore::slots() const {
+    return reinterpret_cast<const std::uint32_t*>(data_ + header().slots_offset);
+}
+
+ProfileView ProfileStore::view(const ProfileStoreRecord& record) const {
+    const std::uint64_t strings_size = header().strings_size;
+    if (static_cast<std::uint64_t>(record.name_offset) + record.name_length > strings_size ||
+        static_cast<std::uint64_t>(record.file_type_offset) + record.file_type_length > strings_size) {
+        throw std::runtime_error("Malformed profile store record");
+    }
+    const char* strings = data_ + header().strings_offset;
+    return {std::string_view(strings + record.name_offset, record.name_length),
+            std::string_view(strings + record.file_type_offset, record.file_type_length),
+            record.alpha, record.kernel};
+}
+
+ProfileView ProfileStore::at(std::size_t index) const {
+    if (index >= size()) {
+        throw std::out_of_range("Profile index out of range");
+    }
+    return view(records()[index]);
+}
+
+std::optional<ProfileView> ProfileStore::find(std::string_view profile_name) const {
+    const std::uint32_t hash = profile_name_hash(profile_name);
+    const std::uint64_t mask = header().slot_count - 1;
+    for (std::uint64_t slot = hash & mask, probes = 0; probes <= mask; slot = (slot + 1) & mask, ++probes) {
+        std::uint32_t entry = slots()[slot];
+        if (entry == 0 || entry > header().record_count) {
+            break;
+        }
+        const ProfileStoreRecord& record = records()[entry - 1];
+        if (record.name_hash == hash) {
+            ProfileView candidate = view(record);
+            if (candidate.profile_name == profile_name) {
+                return candidate;
+            }
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<int> ProfileStore::get_kernel_for_profile(std::string_view profile_name) const {
+    if (auto profile = find(profile_name)) {
+        if (header().metrics_fingerprint == kernel_metrics_fingerprint() && is_valid_kernel_index(profile->kernel)) {
+            return profile->kernel;
+        }
+        return kernel_selection(profile->file_type, profile->alpha);
+    }
+    return std::nullopt;
+}
+
+} // namespace easy_compress_dlib
@@ -0,0 +1,364 @@
+#include "../include/easy_compress_dlib/regression.h"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <tuple>
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+namespace easy_compress_dlib {
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+double median(std::vector<double> samples) {
+    std::sort(samples.begin(), samples.end());
+    const std::size_t n = samples.size();
+    return n % 2 ? samples[n / 2] : (samples[n / 2 - 1] + samples[n / 2]) / 2;
+}
+
+// splitmix64, so intervals are reproducible for a given seed
+class BootstrapRandom {
+public:
+    explicit BootstrapRandom(std::uint64_t seed) : state_(seed) {}
+
+    std::size_t below(std::size_t n) {
+        std::uint64_t z = (state_ += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return static_cast<std::size_t>((z ^ (z >> 31)) % n);
+    }
+
+private:
+    std::uint64_t state_;
+};
+
+double resampled_median(const std::vector<double>& samples, BootstrapRandom& random, std::vector<double>& scratch) {
+    scratch.resize(samples.size());
+    for (auto& value : scratch) {
+        value = samples[random.below(samples.size())];
+    }
+    return median(scratch);
+}
+
+RegressionFinding timing_finding(const BenchmarkResult& current, RegressionMetric metric,
+                                 const std::vector<double>& a, const std::vector<double>& b,
+                                 const RegressionOptions& options) {
+    RegressionFinding finding;
+    finding.subject = current.subject;
+    finding.file_type = current.file_type;
+    finding.input_size = current.input_size;
+    finding.metric = metric;
+    finding.baseline = median(a);
+    finding.current = median(b);
+    finding.change = finding.baseline > 0 ? finding.current / finding.baseline - 1 : 0.0;
+    finding.p_value = mann_whitney_u(a, b).p_value;
+    finding.ratio = bootstrap_median_ratio(a, b, 1 - options.significance, options.bootstrap_iterations,
+                                           options.bootstrap_seed);
+    const bool significant = finding.p_value < options.significance;
+    finding.regression = significant && finding.ratio.low > 1 && finding.change > options.min_change;
+    finding.improvement = significant && finding.ratio.high < 1 && finding.change < -options.min_change;
+    return finding;
+}
+
+std::string join_samples(const std::vector<double>& samples) {
+    std::string out;
+    for (std::size_t i = 0; i < samples.size(); ++i) {
+        char number[32];
+        std::snprintf(number, sizeof(number), "%s%.9g", i ? ";" : "", samples[i]);
+        out += number;
+    }
+    return out;
+}
+
+bool parse_samples(const std::string& field, std::vector<double>& samples) {
+    samples.clear();
+    std::stringstream stream(field);
+    std::string item;
+    while (std::getline(stream, item, ';')) {
+        try {
+            std::size_t used = 0;
+            samples.push_back(std::stod(item, &used));
+            if (used != item.size()) {
+                return false;
+            }
+        } catch (const std::exception&) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool parse_size(const std::string& field, std::size_t& value) {
+    auto result = std::from_chars(field.data(), field.data() + field.size(), value);
+    return result.ec == std::errc() && result.ptr == field.data() + field.size();
+}
+
+} // namespace
+
+MannWhitneyResult mann_whitney_u(const std::vector<double>& a, const std::vector<double>& b) {
+    if (a.empty() || b.empty()) {
+        throw std::invalid_argument("Mann-Whitney U test needs two non-empty samples");
+    }
+    std::vector<std::pair<double, int>> all;
+    all.reserve(a.size() + b.size());
+    for (double value : a) {
+        all.emplace_back(value, 0);
+    }
+    for (double value : b) {
+        all.emplace_back(value, 1);
+    }
+    std::sort(all.begin(), all.end());
+
+    // Average ranks over ties
+    const double n = static_cast<double>(all.size());
+    double rank_sum_a = 0.0;
+    double tie_term = 0.0;
+    for (std::size_t i = 0; i < all.size();) {
+        std::size_t j = i;
+        while (j < all.size() && all[j].first == all[i].first) {
+            ++j;
+        }
+        const double rank = (i + 1 + j) / 2.0;
+        for (std::size_t k = i; k < j; ++k) {
+            if (all[k].second == 0) {
+                rank_sum_a += rank;
+            }
+        }
+        const double t = static_cast<double>(j - i);
+        tie_term += t * t * t - t;
+        i = j;
+    }
+
+    const double n1 = static_cast<double>(a.size());
+    const double n2 = static_cast<double>(b.size());
+    MannWhitneyResult result;
+    result.u = rank_sum_a - n1 * (n1 + 1) / 2;
+    const double mean = n1 * n2 / 2;
+    const double variance = n1 * n2 / 12 * ((n + 1) - tie_term / (n * (n - 1)));
+    if (variance <= 0) {
+        return result;   // every value tied
+    }
+    // Continuity correction towards the mean
+    const double distance = std::max(0.0, std::abs(result.u - mean) - 0.5);
+    result.z = std::copysign(distance / std::sqrt(variance), result.u - mean);
+    result.p_value = std::erfc(distance / std::sqrt(variance) / std::sqrt(2.0));
+    return result;
+}
+
+ConfidenceInterval bootstrap_median_ratio(const std::vector<double>& a, const std::vector<double>& b,
+                                          double confidence, unsigned iterations, std::uint64_t seed) {
+    if (a.empty() || b.empty()) {
+        throw std::invalid_argument("Bootstrap needs two non-empty samples");
+    }
+    BootstrapRandom random(seed);
+    std::vector<double> ratios;
+    ratios.reserve(std::max(1u, iterations));
+    std::vector<double> scratch;
+    for (unsigned i = 0; i < std::max(1u, iterations); ++i) {
+        const double median_a = resampled_median(a, random, scratch);
+        const double median_b = resampled_median(b, random, scratch);
+        ratios.push_back(median_a > 0 ? median_b / median_a : 1.0);
+    }
+    std::sort(ratios.begin(), ratios.end());
+    const double tail = (1 - confidence) / 2;
+    auto at = [&](double q) {
+        const std::size_t index = static_cast<std::size_t>(q * (ratios.size() - 1) + 0.5);
+        return ratios[std::min(index, ratios.size() - 1)];
+    };
+    return {at(tail), at(1 - tail)};
+}
+
+const char* regression_metric_name(RegressionMetric metric) {
+    switch (metric) {
+        case RegressionMetric::compress_time:   return "compress_time";
+        case RegressionMetric::decompress_time: return "decompress_time";
+        case RegressionMetric::compressed_size: return "compressed_size";
+        case RegressionMetric::round_trip:      return "round_trip";
+    }
+    return "unknown";
+}
+
+std::vector<RegressionFinding> compare_result(const BenchmarkResult& baseline, const BenchmarkResult& current,
+                                              const RegressionOptions& options) {
+    std::vector<RegressionFinding> findings;
+    if (!current.round_trip) {
+        RegressionFinding finding;
+        finding.subject = current.subject;
+        finding.file_type = current.file_type;
+        finding.input_size = current.input_size;
+        finding.metric = RegressionMetric::round_trip;
+        finding.baseline = baseline.round_trip;
+        finding.regression = baseline.round_trip;
+        findings.push_back(finding);
+        return findings;
+    }
+    if (!baseline.compress_seconds.empty() && !current.compress_seconds.empty()) {
+        findings.push_back(timing_finding(current, RegressionMetric::compress_time,
+                                          baseline.compress_seconds, current.compress_seconds, options));
+    }
+    if (!baseline.decompress_seconds.empty() && !current.decompress_seconds.empty()) {
+        findings.push_back(timing_finding(current, RegressionMetric::decompress_time,
+                                          baseline.decompress_seconds, current.decompress_seconds, options));
+    }
+
+    RegressionFinding size;
+    size.subject = current.subject;
+    size.file_type = current.file_type;
+    size.input_size = current.input_size;
+    size.metric = RegressionMetric::compressed_size;
+    size.baseline = static_cast<double>(baseline.compressed_size);
+    size.current = static_cast<double>(current.compressed_size);
+    size.change = size.baseline > 0 ? size.current / size.baseline - 1 : 0.0;
+    size.p_value = 0.0;
+    size.ratio = {size.change + 1, size.change + 1};
+    size.regression = size.change > options.ratio_tolerance;
+    size.improvement = size.change < -options.ratio_tolerance;
+    findings.push_back(size);
+    return findings;
+}
+
+std::vector<RegressionFinding> compare_results(const std::vector<BenchmarkResult>& baseline,
+                                               const std::vector<BenchmarkResult>& current,
+                                               const RegressionOptions& options) {
+    std::map<std::tuple<std::string, std::string, std::size_t>, const BenchmarkResult*> cases;
+    for (const auto& result : baseline) {
+        cases[{result.subject, result.file_type, result.input_size}] = &result;
+    }
+    std::vector<RegressionFinding> findings;
+    for (const auto& result : current) {
+        auto it = cases.find({result.subject, result.file_type, result.input_size});
+        if (it == cases.end()) {
+            continue;
+        }
+        for (auto& finding : compare_result(*it->second, result, options)) {
+            findings.push_back(std::move(finding));
+        }
+    }
+    return findings;
+}
+
+void save_baseline(const std::string& filename, const std::vector<BenchmarkResult>& results, std::uint64_t seed) {
+    std::ofstream file(filename);
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to open file for writing: " + filename);
+    }
+    file << baseline_seed_prefix << seed << "\n";
+    for (const auto& r : results) {
+        if (!r.round_trip) {
+            continue;   // nothing worth comparing against
+        }
+        file << r.subject << "," << r.file_type << "," << r.input_size << "," << r.compressed_size << ","
+             << join_samples(r.compress_seconds) << "," << join_samples(r.decompress_seconds) << "\n";
+    }
+    if (!file) {
+        throw std::runtime_error("Failed to write baseline: " + filename);
+    }
+}
+
+std::vector<BenchmarkResult> load_baseline(const std::string& filename, std::uint64_t* seed) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to open file: " + filename);
+    }
+    std::vector<BenchmarkResult> results;
+    std::string line;
+    int line_number = 0;
+    while (std::getline(file, line)) {
+        line_number++;
+        if (line.compare(0, baseline_seed_prefix.size(), baseline_seed_prefix) == 0) {
+            if (seed) {
+                *seed = std::strtoull(line.c_str() + baseline_seed_prefix.size(), nullptr, 10);
+            }
+            continue;
+        }
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::vector<std::string> fields;
+        std::stringstream stream(line);
+        std::string field;
+        while (std::getline(stream, field, ',')) {
+            fields.push_back(field);
+        }
+        if (fields.size() != 6) {
+            std::cerr << "Incorrect format on line " << line_number << ": Expected 6 comma-separated values" << std::endl;
+            continue;
+        }
+        BenchmarkResult result;
+        result.subject = fields[0];
+        result.file_type = fields[1];
+        result.round_trip = true;
+        if (!parse_size(fields[2], result.input_size) || !parse_size(fields[3], result.compressed_size) ||
+            !parse_samples(fields[4], result.compress_seconds) || !parse_samples(fields[5], result.decompress_seconds)) {
+            std::cerr << "Error on line " << line_number << ": invalid size or timing" << std::endl;
+            continue;
+        }
+        results.push_back(std::move(result));
+    }
+    return results;
+}
+
+std::pair<BenchmarkResult, BenchmarkResult> run_ab_case(const BenchmarkSubject& a, const BenchmarkSubject& b,
+                                                        std::string_view file_type, const std::string& input,
+                                                        const BenchmarkOptions& options) {
+    std::pair<BenchmarkResult, BenchmarkResult> results;
+    const BenchmarkSubject* subjects[2] = {&a, &b};
+    BenchmarkResult* outputs[2] = {&results.first, &results.second};
+    std::string compressed[2];
+    std::string decompressed;
+
+    for (int s = 0; s < 2; ++s) {
+        BenchmarkResult& result = *outputs[s];
+        result.subject = subjects[s]->name;
+        result.file_type = file_type;
+        result.input_size = input.size();
+        try {
+            subjects[s]->compress(input, compressed[s]);
+            subjects[s]->decompress(compressed[s], decompressed, input.size());
+            result.compressed_size = compressed[s].size();
+            result.round_trip = decompressed == input;
+        } catch (const std::exception& e) {
+            result.error = e.what();
+        }
+    }
+    if (!results.first.round_trip || !results.second.round_trip) {
+        return results;
+    }
+
+    const unsigned repetitions = benchmark_repetitions(input.size(), options);
+    for (unsigned r = 0; r < repetitions; ++r) {
+        for (int s = 0; s < 2; ++s) {
+            auto start = clock_type::now();
+            subjects[s]->compress(input, compressed[s]);
+            outputs[s]->compress_seconds.push_back(std::chrono::duration<double>(clock_type::now() - start).count());
+            start = clock_type::now();
+            subjects[s]->decompress(compressed[s], decompressed, input.size());
+            outputs[s]->decompress_seconds.push_back(std::chrono::duration<double>(clock_type::now() - start).count());
+        }
+    }
+    return results;
+}
+
+bool pin_to_cpu(unsigned cpu) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+} // namespace easy_compress_dlib
@@ -0,0 +1,67 @@
+#include "../include/easy_compress_dlib/run_detector.h"
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+
+namespace easy_compress_dlib {
+
+namespace {
+
+constexpr std::uint64_t byte_broadcast = 0x0101010101010101ull;
+
+std::uint64_t load_word(const char* p) {
+    std::uint64_t word;
+    std::memcpy(&word, p, sizeof(word));
+    return word;
+}
+
+} // namespace
+
+std::size_t run_length_at(std::string_view data, std::size_t position) {
+    if (position >= data.size()) {
+        return 0;
+    }
+    const std::uint64_t pattern = static_cast<unsigned char>(data[position]) * byte_broadcast;
+    std::size_t i = position;
+    for (; i + 8 <= data.size(); i += 8) {
+        const std::uint64_t diff = load_word(data.data() + i) ^ pattern;
+        if (diff != 0) {
+            // First differing byte, in memory order
+            const int bit = std::endian::native == std::endian::little ? std::countr_zero(diff) : std::countl_zero(diff);
+            return i + bit / 8 - position;
+        }
+    }
+    while (i < data.size() && data[i] == data[position]) {
+        ++i;
+    }
+    return i - position;
+}
+
+ByteRun find_run(std::string_view data, std::size_t from, std::size_t min_length) {
+    min_length = std::max(min_length, min_detectable_run);
+    std::size_t word = (from + 7) & ~std::size_t(7);
+    while (word + 8 <= data.size()) {
+        const std::uint64_t value = load_word(data.data() + word);
+        if (value != (value & 0xFF) * byte_broadcast) {
+            word += 8;
+            continue;
+        }
+        std::size_t start = word;
+        while (start > from && data[start - 1] == data[word]) {
+            --start;
+        }
+        const std::size_t length = run_length_at(data, start);
+        if (length >= min_length) {
+            return {start, length, static_cast<unsigned char>(data[start])};
+        }
+        word = (start + length + 7) & ~std::size_t(7);
+    }
+    return {data.size(), 0, 0};
+}
+
+bool is_single_run(std::string_view data) {
+    return !data.empty() && run_length_at(data, 0) == data.size();
+}
+
+} // namespace easy_compress_dlib
@@ -0,0 +1,417 @@
+#include "../include/easy_compress_dlib/synthetic_corpus.h"
+#include "../include/easy_compress_dlib/kernel_metrics_table.h"
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+
+namespace easy_compress_dlib {
+
+namespace {
+
+// splitmix64; the standard distributions differ between library
+// implementations, so all sampling below is done by hand
+class CorpusRandom {
+public:
+    explicit CorpusRandom(std::uint64_t seed) : state_(seed ^ 0x6A09E667F3BCC909ull) {}
+
+    std::uint64_t next() {
+        std::uint64_t z = (state_ += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    // Uniform in [0, n)
+    std::size_t below(std::size_t n) { return static_cast<std::size_t>(next() % n); }
+
+    // Index into n items, heavily skewed towards the front like word frequencies
+    std::size_t skewed(std::size_t n) {
+        const double u = static_cast<double>(next() >> 11) / 9007199254740992.0;
+        return static_cast<std::size_t>(u * u * u * n);
+    }
+
+    bool chance(unsigned percent) { return below(100) < percent; }
+
+private:
+    std::uint64_t state_;
+};
+
+template <std::size_t N>
+std::string_view pick(CorpusRandom& random, const std::array<std::string_view, N>& items) {
+    return items[random.skewed(N)];
+}
+
+constexpr std::array<std::string_view, 64> common_words = {
+    "the", "of", "and", "to", "a", "in", "that", "it", "was", "he", "for", "on", "is", "with", "as", "his",
+    "she", "at", "be", "by", "had", "not", "but", "from", "her", "they", "you", "this", "which", "said",
+    "all", "were", "there", "one", "so", "what", "would", "when", "been", "upon", "into", "very", "little",
+    "could", "time", "about", "out", "then", "them", "some", "know", "thought", "queen", "like", "went",
+    "again", "head", "way", "door", "voice", "garden", "looked", "without", "nothing"
+};
+
+constexpr std::array<std::string_view, 32> technical_words = {
+    "system", "data", "process", "control", "signal", "network", "memory", "interface", "protocol",
+    "channel", "function", "value", "module", "device", "address", "frequency", "transmission", "input",
+    "output", "software", "hardware", "processor", "register", "message", "sequence", "operation",
+    "parameter", "structure", "analysis", "circuit", "terminal", "standard"
+};
+
+constexpr std::array<std::string_view, 12> acronyms = {
+    "CPU", "ISO", "TCP", "RAM", "ROM", "DMA", "ASCII", "IEEE", "LAN", "CCITT", "VLSI", "I/O"
+};
+
+constexpr std::array<std::string_view, 10> speakers = {
+    "ROSALIND", "CELIA", "ORLANDO", "TOUCHSTONE", "JAQUES", "DUKE SENIOR", "OLIVER", "ADAM", "PHEBE", "SILVIUS"
+};
+
+constexpr std::array<std::string_view, 24> c_identifiers = {
+    "i", "n", "p", "len", "buf", "ptr", "count", "value", "result", "node", "next", "size", "field", "index",
+    "error", "flags", "data", "state", "offset", "limit", "table", "entry", "key", "tmp"
+};
+
+constexpr std::array<std::string_view, 12> c_types = {
+    "int", "char", "long", "unsigned", "double", "void", "struct field", "short", "FILE", "size_t",
+    "static int", "register int"
+};
+
+constexpr std::array<std::string_view, 16> lisp_symbols = {
+    "car", "cdr", "cons", "list", "null", "eq", "cond", "setq", "append", "reverse", "member", "assoc",
+    "lambda", "mapcar", "apply", "funcall"
+};
+
+constexpr std::array<std::string_view, 14> html_tags = {
+    "p", "a", "li", "b", "i", "td", "tr", "font", "em", "strong", "span", "div", "h2", "code"
+};
+
+constexpr std::array<std::string_view, 10> troff_macros = {
+    ".PP", ".TP", ".B", ".I", ".BR", ".IR", ".RS", ".RE", ".IP", ".SH"
+};
+
+void append_words(CorpusRandom& random, std::string& out, std::size_t count, bool technical) {
+    for (std::size_t w = 0; w < count; ++w) {
+        if (w != 0) {
+            out.push_back(' ');
+        }
+        if (technical && random.chance(3)) {
+            out += pick(random, acronyms);
+        } else if (technical && random.chance(30)) {
+            out += pick(random, technical_words);
+        } else {
+            out += pick(random, common_words);
+        }
+        if (random.chance(6)) {
+            out.push_back(',');
+        }
+    }
+}
+
+void capitalize(std::string& out, std::size_t position) {
+    if (out[position] >= 'a' && out[position] <= 'z') {
+        out[position] = static_cast<char>(out[position] - 'a' + 'A');
+    }
+}
+
+void append_sentence(CorpusRandom& random, std::string& out, bool technical) {
+    const std::size_t start = out.size();
+    append_words(random, out, 5 + random.below(16), technical);
+    capitalize(out, start);
+    out += random.chance(10) ? "? " : ". ";
+}
+
+// Prose wrapped at about `width` columns
+void append_paragraph(CorpusRandom& random, std::string& out, std::size_t width, bool technical) {
+    std::string paragraph;
+    for (std::size_t s = 0, sentences = 2 + random.below(6); s < sentences; ++s) {
+        append_sentence(random, paragraph, technical);
+    }
+    std::size_t column = 0;
+    std::size_t word_start = 0;
+    for (std::size_t i = 0; i <= paragraph.size(); ++i) {
+        if (i != paragraph.size() && paragraph[i] != ' ') {
+            continue;
+        }
+        const std::size_t length = i - word_start;
+        if (length != 0) {
+            if (column != 0 && column + 1 + length > width) {
+                out.push_back('\n');
+                column = 0;
+            } else if (column != 0) {
+                out.push_back(' ');
+                ++column;
+            }
+            out.append(paragraph, word_start, length);
+            column += length;
+        }
+        word_start = i + 1;
+    }
+    out += "\n\n";
+}
+
+void put_u16_le(std::string& out, std::uint16_t value) {
+    out.push_back(static_cast<char>(value & 0xFF));
+    out.push_back(static_cast<char>(value >> 8));
+}
+
+void put_u32_be(std::string& out, std::uint32_t value) {
+    for (int i = 3; i >= 0; --i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+void generate_text(CorpusRandom& random, std::string& out, std::size_t size) {
+    while (out.size() < size) {
+        append_paragraph(random, out, 70, false);
+    }
+}
+
+void generate_tech(CorpusRandom& random, std::string& out, std::size_t size) {
+    std::size_t section = 1;
+    while (out.size() < size) {
+        out += std::to_string(section) + "." + std::to_string(1 + random.below(9)) + "  ";
+        append_words(random, out, 2 + random.below(4), true);
+        out += "\n\n";
+        for (std::size_t p = 0, paragraphs = 1 + random.below(4); p < paragraphs; ++p) {
+            append_paragraph(random, out, 72, true);
+        }
+        if (random.chance(20)) {
+            ++section;
+        }
+    }
+}
+
+void generate_poem(CorpusRandom& random, std::string& out, std::size_t size) {
+    while (out.size() < size) {
+        for (std::size_t l = 0, lines = 4 + random.below(5); l < lines; ++l) {
+            const std::size_t start = out.size();
+            append_words(random, out, 4 + random.below(5), false);
+            capitalize(out, start);
+            out += random.chance(30) ? ";\n" : ",\n";
+        }
+        out.push_back('\n');
+    }
+}
+
+void generate_play(CorpusRandom& random, std::string& out, std::size_t size) {
+    while (out.size() < size) {
+        if (random.chance(8)) {
+            out += "\t[Exit ";
+            out += pick(random, speakers);
+            out += "]\n\n";
+            continue;
+        }
+        out += pick(random, speakers);
+        out.push_back('\n');
+        for (std::size_t l = 0, lines = 1 + random.below(6); l < lines; ++l) {
+            out.push_back('\t');
+            const std::size_t start = out.size();
+            append_words(random, out, 5 + random.below(6), false);
+            capitalize(out, start);
+            out.push_back('\n');
+        }
+        out.push_back('\n');
+    }
+}
+
+void generate_html(CorpusRandom& random, std::string& out, std::size_t size) {
+    out += "<html>\n<head>\n<title>Synthetic page</title>\n</head>\n<body bgcolor=\"#ffffff\">\n";
+    while (out.size() < size) {
+        const std::string_view tag = pick(random, html_tags);
+        out += "<";
+        out += tag;
+        if (tag == "a") {
+            out += " href=\"/pub/";
+            out += pick(random, common_words);
+            out += ".html\"";
+        } else if (tag == "font") {
+            out += " size=\"" + std::to_string(1 + random.below(4)) + "\"";
+        }
+        out += ">";
+        append_words(random, out, 1 + random.below(10), false);
+        out += "</";
+        out += tag;
+        out += ">\n";
+    }
+}
+
+void generate_csrc(CorpusRandom& random, std::string& out, std::size_t size) {
+    out += "#include <stdio.h>\n#include <stdlib.h>\n\n";
+    std::size_t function = 0;
+    while (out.size() < size) {
+        out += pick(random, c_types);
+        out += " f" + std::to_string(function++) + "(";
+        out += pick(random, c_types);
+        out += " ";
+        out += pick(random, c_identifiers);
+        out += ")\n{\n";
+        for (std::size_t s = 0, statements = 3 + random.below(12); s < statements; ++s) {
+            const std::size_t kind = random.below(5);
+            out += "\t";
+            if (kind == 0) {
+                out += "if (";
+                out += pick(random, c_identifiers);
+                out += " == NULL)\n\t\treturn -1;\n";
+            } else if (kind == 1) {
+                out += "for (i = 0; i < ";
+                out += pick(random, c_identifiers);
+                out += "; i++)\n\t\t";
+                out += pick(random, c_identifiers);
+                out += "[i] = 0;\n";
+            } else {
+                out += pick(random, c_identifiers);
+                out += " = ";
+                out += pick(random, c_identifiers);
+                out += random.chance(50) ? "->" : " + ";
+                out += pick(random, c_identifiers);
+                out += ";\n";
+            }
+        }
+        out += "\treturn ";
+        out += pick(random, c_identifiers);
+        out += ";\n}\n\n";
+    }
+}
+
+void generate_list(CorpusRandom& random, std::string& out, std::size_t size) {
+    std::size_t function = 0;
+    while (out.size() < size) {
+        out += ";;; " + std::string(pick(random, common_words)) + "\n";
+        out += "(defun rule" + std::to_string(function++) + " (";
+        out += pick(random, c_identifiers);
+        out += ")\n";
+        std::size_t depth = 1;
+        for (std::size_t s = 0, forms = 2 + random.below(8); s < forms; ++s) {
+            out += std::string(2 * depth, ' ') + "(";
+            out += pick(random, lisp_symbols);
+            out += " ";
+            out += pick(random, c_identifiers);
+            if (random.chance(40) && depth < 6) {
+                out += "\n";
+                ++depth;
+            } else {
+                out += ")\n";
+            }
+        }
+        out += std::string(depth, ')') + "\n\n";
+    }
+}
+
+void generate_man(CorpusRandom& random, std::string& out, std::size_t size) {
+    out += ".TH SYNTH 1 \"\" \"\" \"User Commands\"\n.SH NAME\nsynth \\- generate data\n.SH SYNOPSIS\n";
+    while (out.size() < size) {
+        out += pick(random, troff_macros);
+        if (random.chance(50)) {
+            out += " \\-";
+            out.push_back(static_cast<char>('a' + random.below(26)));
+        }
+        out.push_back('\n');
+        append_paragraph(random, out, 65, false);
+        out.pop_back();
+    }
+}
+
+// Cells of a sheet filled row by row: u16 row | u16 column | u16 format |
+// u16 reserved | f64 value; neighbouring cells hold similar values
+void generate_excl(CorpusRandom& random, std::string& out, std::size_t size) {
+    const std::uint16_t columns = static_cast<std::uint16_t>(4 + random.below(12));
+    std::uint64_t value_bits = 0x40590000u;   // high word of 100.0
+    for (std::uint16_t row = 0; out.size() < size; ++row) {
+        for (std::uint16_t column = 0; column < columns; ++column) {
+            put_u16_le(out, row);
+            put_u16_le(out, column);
+            put_u16_le(out, static_cast<std::uint16_t>(0x0F + (column % 3)));
+            put_u16_le(out, 0);
+            value_bits += random.below(64) - 32;
+            const std::uint64_t value = (value_bits << 32) | (random.chance(70) ? 0 : random.next() >> 40);
+            for (int b = 0; b < 8; ++b) {
+                out.push_back(static_cast<char>((value >> (8 * b)) & 0xFF));
+            }
+        }
+    }
+}
+
+// 1728 pixels per line, 8 per byte; black runs mostly continue from the line above
+void generate_fax(CorpusRandom& random, std::string& out, std::size_t size) {
+    constexpr std::size_t line_bytes = 1728 / 8;
+    std::string line(line_bytes, '\0');
+    while (out.size() < size) {
+        if (random.chance(30)) {
+            line.assign(line_bytes, '\0');
+            for (std::size_t marks = random.below(6); marks > 0; --marks) {
+                const std::size_t start = random.below(line_bytes);
+                const std::size_t length = 1 + random.below(12);
+                for (std::size_t i = start; i < std::min(line_bytes, start + length); ++i) {
+                    line[i] = static_cast<char>(random.chance(80) ? 0xFF : random.next());
+                }
+            }
+        }
+        out += line;
+    }
+}
+
+// SPARC instruction words: format 3 arithmetic and loads with random registers,
+// calls (op 01) and sethi, followed now and then by a string table
+void generate_sprc(CorpusRandom& random, std::string& out, std::size_t size) {
+    constexpr std::array<std::uint32_t, 8> op3 = {0x00, 0x02, 0x04, 0x10, 0x14, 0x20, 0x24, 0x3C};
+    while (out.size() < size) {
+        for (std::size_t n = 0, words = 64 + random.below(512); n < words; ++n) {
+            const std::size_t kind = random.below(10);
+            std::uint32_t word;
+            if (kind == 0) {
+                word = 0x40000000u | static_cast<std::uint32_t>(random.below(1u << 16));   // call
+            } else if (kind == 1) {
+                word = 0x01000000u;                                                         // nop
+            } else if (kind == 2) {
+                word = (static_cast<std::uint32_t>(random.skewed(32)) << 25) | 0x04u << 22 |
+                       static_cast<std::uint32_t>(random.below(1u << 12)) << 10;             // sethi
+            } else {
+                const std::uint32_t op = kind < 6 ? 2u : 3u;
+                word = op << 30 | static_cast<std::uint32_t>(random.skewed(32)) << 25 | op3[random.skewed(8)] << 19 |
+                       static_cast<std::uint32_t>(random.skewed(32)) << 14;
+                word |= random.chance(50) ? (1u << 13 | static_cast<std::uint32_t>(random.skewed(64) * 4))
+                                          : static_cast<std::uint32_t>(random.skewed(32));
+            }
+            put_u32_be(out, word);
+        }
+        if (random.chance(25)) {
+            for (std::size_t s = 0, strings = 4 + random.below(16); s < strings; ++s) {
+                out += "_";
+                out += pick(random, c_identifiers);
+                out += "_";
+                out += pick(random, common_words);
+                out.push_back('\0');
+            }
+            while (out.size() % 4 != 0) {
+                out.push_back('\0');
+            }
+        }
+    }
+}
+
+} // namespace
+
+std::string generate_corpus(std::string_view file_type, std::size_t size, std::uint64_t seed) {
+    const auto type = parse_file_type(file_type);
+    if (!type) {
+        throw std::invalid_argument("Unknown file type: " + std::string(file_type));
+    }
+    CorpusRandom random(seed * file_type_count + static_cast<std::uint64_t>(*type));
+    std::string out;
+    out.reserve(size + 4096);
+    switch (*type) {
+        case FileTypeId::text: generate_text(random, out, size); break;
+        case FileTypeId::play: generate_play(random, out, size); break;
+        case FileTypeId::html: generate_html(random, out, size); break;
+        case FileTypeId::Csrc: generate_csrc(random, out, size); break;
+        case FileTypeId::list: generate_list(random, out, size); break;
+        case FileTypeId::Excl: generate_excl(random, out, size); break;
+        case FileTypeId::tech: generate_tech(random, out, size); break;
+        case FileTypeId::poem: generate_poem(random, out, size); break;
+        case FileTypeId::fax:  generate_fax(random, out, size); break;
+        case FileTypeId::SPRC: generate_sprc(random, out, size); break;
+        case FileTypeId::man:  generate_man(random, out, size); break;
+    }
+    out.resize(size);
+    return out;
+}
+
+} // namespace easy_compress_dlib
@@ -0,0 +1,155 @@
+#include "../include/easy_compress_dlib/thread_pool.h"
+#include <algorithm>
+#include <chrono>
+
+namespace easy_compress_dlib {
+
+namespace {
+
+// The pool and queue of the worker running on this thread, if any
+thread_local const ThreadPool* current_pool = nullptr;
+thread_local std::size_t current_queue = 0;
+
+} // namespace
+
+ThreadPool::ThreadPool(unsigned threads) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (unsigned i = 0; i < threads; ++i) {
+        queues_.push_back(std::make_unique<Queue>());
+    }
+    workers_.reserve(threads);
+    for (unsigned i = 0; i < threads; ++i) {
+        workers_.emplace_back([this, i] { worker_loop(i); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    const std::size_t target = current_pool == this ? current_queue : next_queue_++ % queues_.size();
+    // Counted before it is queued so pop() never takes pending_ below zero
+    pending_++;
+    {
+        std::lock_guard<std::mutex> lock(queues_[target]->mutex);
+        queues_[target]->tasks.push_back(std::move(task));
+    }
+    // Taking the lock orders the increment before a sleeping worker's check
+    std::lock_guard<std::mutex> lock(sleep_mutex_);
+    wake_.notify_one();
+}
+
+bool ThreadPool::pop(std::size_t self, std::function<void()>& task) {
+    if (pending_ == 0) {
+        return false;
+    }
+    {
+        Queue& own = *queues_[self];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            pending_--;
+            return true;
+        }
+    }
+    for (std::size_t k = 1; k < queues_.size(); ++k) {
+        Queue& victim = *queues_[(self + k) % queues_.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            pending_--;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ThreadPool::run_pending() {
+    const std::size_t self = current_pool == this ? current_queue : next_queue_++ % queues_.size();
+    std::function<void()> task;
+    if (!pop(self, task)) {
+        return false;
+    }
+    task();
+    return true;
+}
+
+void ThreadPool::worker_loop(std::size_t index) {
+    current_pool = this;
+    current_queue = index;
+    std::function<void()> task;
+    while (true) {
+        if (pop(index, task)) {
+            task();
+            task = nullptr;
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
+        wake_.wait(lock, [this] { return stopping_ || pending_ != 0; });
+        if (stopping_ && pending_ == 0) {
+            return;
+        }
+    }
+}
+
+TaskGroup::~TaskGroup() {
+    try {
+        wait();
+    } catch (...) {
+    }
+}
+
+void TaskGroup::run(std::function<void()> task) {
+    outstanding_++;
+    pool_.submit([this, task = std::move(task)] {
+        try {
+            task();
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!error_) {
+                error_ = std::current_exception();
+            }
+        }
+        finish_one();
+    });
+}
+
+void TaskGroup::finish_one() {
+    // Notify under the lock so the group cannot be destroyed between the
+    // decrement and the notification
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (--outstanding_ == 0) {
+        done_.notify_all();
+    }
+}
+
+void TaskGroup::wait() {
+    while (outstanding_ != 0) {
+        if (pool_.run_pending()) {
+            continue;
+        }
+        // Tasks of this group may still queue more work, so look again shortly
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_.wait_for(lock, std::chrono::milliseconds(1), [this] { return outstanding_ == 0; });
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (error_) {
+        std::exception_ptr error = error_;
+        error_ = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+} // namespace easy_compress_dlib